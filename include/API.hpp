@@ -3,6 +3,11 @@
 #include <Sapphire/Loader.hpp>
 #include <cocos2d.h>
 #include <Sapphire/Utils.hpp>
+#include <array>
+#include <bit>
+#include <filesystem>
+#include <limits>
+#include <memory>
 
 #ifdef SAPPHIRE_IS_WINDOWS
     #ifdef SAPPHIRE_MOUSEAPI_EXPORTING
@@ -22,6 +27,7 @@
 struct CCEGLViewModify;
 struct CCTouchDispatcherModify;
 class MouseEventListenerPool;
+class SceneSnapshot;
 
 namespace mouse {
     enum class MouseButton {
@@ -38,6 +44,271 @@ namespace mouse {
         Leave   = 0,
     };
 
+    /**
+     * Types of mouse events as bit flags, used for choosing which events a 
+     * listener is interested in
+     */
+    enum class MouseEventType : unsigned int {
+        Click   = 1 << 0,
+        Move    = 1 << 1,
+        Scroll  = 1 << 2,
+        Hover   = 1 << 3,
+        // Gestures recognized from the raw click & move events. These are 
+        // only delivered to listeners that explicitly subscribe to them
+        DoubleClick = 1 << 4,
+        LongPress   = 1 << 5,
+        Drag        = 1 << 6,
+    };
+
+    constexpr unsigned int operator|(MouseEventType a, MouseEventType b) {
+        return static_cast<unsigned int>(a) | static_cast<unsigned int>(b);
+    }
+    constexpr unsigned int operator|(unsigned int a, MouseEventType b) {
+        return a | static_cast<unsigned int>(b);
+    }
+
+    /**
+     * Number of MouseEventType flags
+     */
+    static constexpr size_t MOUSE_EVENT_TYPE_COUNT = 7;
+
+    /**
+     * The event types every listener receives by default
+     */
+    static constexpr unsigned int MOUSE_EVENTS_DEFAULT =
+        MouseEventType::Click | MouseEventType::Move |
+        MouseEventType::Scroll | MouseEventType::Hover;
+
+    /**
+     * Thresholds used for recognizing gestures
+     */
+    struct GestureSettings {
+        // Maximum time between the presses of a double click, in seconds
+        float doubleClickInterval = .3f;
+        // Maximum distance between the presses of a double click
+        float doubleClickDistance = 5.f;
+        // How long a button has to be held without dragging for a long press
+        float longPressDelay = .5f;
+        // How far the mouse has to move while a button is held to start a drag
+        float dragThreshold = 4.f;
+    };
+
+    /**
+     * When a listener is invoked. Immediate listeners are invoked while the 
+     * event is being dispatched, while deferred listeners' callbacks are 
+     * queued and invoked later within a per-frame time budget. Hit testing, 
+     * hover state, capturing & eating still happen during the dispatch, 
+     * using the result the callback returned last time. Use deferred for 
+     * listeners that aren't latency-critical, like hover effects
+     */
+    enum class PriorityClass {
+        Immediate,
+        Deferred,
+    };
+
+    /**
+     * Built-in behaviors for the listeners this API adds to touch delegates 
+     * and menus. These listeners have no callback, as the pool evaluates 
+     * their behavior itself
+     */
+    enum class DelegateProxy {
+        // A regular listener with a callback
+        None,
+        // Eat every event, like standard & non-swallowing touch delegates
+        Eat,
+        // Swallow every event, like swallowing touch delegates
+        Swallow,
+        // Swallow events over any of the target's children, like CCMenu
+        MenuChildren,
+    };
+
+    /**
+     * Counters for the deferred listener queue
+     */
+    struct DeferredStats {
+        // Events currently waiting to be delivered to deferred listeners
+        size_t backlog = 0;
+        // Highest backlog so far
+        size_t peakBacklog = 0;
+        // Events queued for deferred listeners
+        size_t queued = 0;
+        // Queued events replaced by a newer event of the same type
+        size_t coalesced = 0;
+        // Events delivered to deferred listeners
+        size_t processed = 0;
+        // Frames where the budget ran out before the queue was empty
+        size_t overBudgetFrames = 0;
+    };
+
+    /**
+     * Counters for the mouse event pipeline since the last reset
+     */
+    struct MouseStats {
+        // Events dispatched, indexed by the bit position of their type. 
+        // Use getEventCount instead of indexing directly
+        std::array<uint64_t, MOUSE_EVENT_TYPE_COUNT> events {};
+        // Listeners looked at during dispatch, including ones skipped 
+        // without being invoked
+        uint64_t listenersVisited = 0;
+        uint64_t listenersInvoked = 0;
+        // Hit tests computed, and ones answered from the per-position cache
+        uint64_t hitTests = 0;
+        uint64_t hitTestCacheHits = 0;
+        uint64_t hoverEnters = 0;
+        uint64_t hoverLeaves = 0;
+        uint64_t captures = 0;
+        uint64_t releases = 0;
+        uint64_t sorts = 0;
+        // Total time spent sorting listeners, in seconds
+        double sortTime = 0.0;
+        // Objects allocated by MouseAttributes::from & MouseEvent::createTouch
+        uint64_t attributeAllocations = 0;
+        uint64_t touchAllocations = 0;
+
+        // These describe the current state and aren't affected by resets
+        size_t listenerCount = 0;
+        size_t listenerSlotCount = 0;
+        // Touches created by MouseEvent::createTouch that haven't been 
+        // freed yet, which should stay close to the number of nodes 
+        // eating the mouse
+        uint64_t touchesAlive = 0;
+        DeferredStats deferred;
+
+        uint64_t getEventCount(MouseEventType type) const {
+            auto index = static_cast<size_t>(std::countr_zero(static_cast<unsigned int>(type)));
+            return index < events.size() ? events[index] : 0;
+        }
+    };
+
+    /**
+     * A consistent copy of the global pointer state, which can be read 
+     * from any thread
+     */
+    struct MouseState {
+        // Bit n is set while MouseButton n is held
+        uint32_t buttons = 0;
+        // Last known cursor position in cocos coordinates
+        cocos2d::CCPoint position;
+        // Total scroll deltas received since startup. Diff two states to 
+        // get the scroll in between
+        float scrollX = 0.f;
+        float scrollY = 0.f;
+        // Bumped on every update, so an unchanged sequence means nothing 
+        // changed between two reads
+        uint64_t sequence = 0;
+
+        bool isHeld(MouseButton button) const {
+            auto index = static_cast<uint32_t>(button);
+            return index < 32 && (buttons & (uint32_t(1) << index));
+        }
+    };
+
+    /**
+     * A dispatch recorded in the event timeline
+     */
+    struct MouseTimelineEntry {
+        // Sequence number of the dispatch
+        uint64_t index = 0;
+        MouseEventType type = MouseEventType::Move;
+        cocos2d::CCPoint position;
+        // Time in seconds, only meaningful relative to other entries
+        double time = 0.0;
+        // Time spent dispatching in seconds, including nested dispatches
+        float duration = 0.f;
+        // Events posted from inside another dispatch, like hover events, 
+        // have a depth above 0
+        uint32_t depth = 0;
+        // Number of listeners invoked
+        uint32_t invoked = 0;
+        bool swallowed = false;
+        // These nodes may have been freed since, so only use them for 
+        // comparisons and logging
+        cocos2d::CCNode* target = nullptr;
+        cocos2d::CCNode* swallowedBy = nullptr;
+        cocos2d::CCNode* capturing = nullptr;
+    };
+
+    /**
+     * A listener whose target isn't in the running scene, found by 
+     * Mouse::auditListeners
+     */
+    struct OrphanedListener {
+        // Address of the listener, only meant for telling listeners apart
+        uintptr_t id = 0;
+        // Class name of the target
+        std::string nodeType;
+        // Frames since the target was first seen outside of the scene
+        unsigned int age = 0;
+        // Times the listener was invoked since then, each of which cost a 
+        // visibility check without doing anything
+        uint64_t invocations = 0;
+        // Whether the listener has been parked until its target enters the 
+        // scene again
+        bool cold = false;
+    };
+
+    enum class HitShapeType {
+        // The target's bounding box in its parent's space
+        Bounds,
+        // The target's content rect, which stays correct for rotated nodes
+        Rect,
+        Circle,
+        Polygon,
+        Mask,
+    };
+
+    /**
+     * The area of a target that counts as being under the mouse, tested 
+     * while hit testing so positions outside of it never reach the 
+     * listener. Shapes are in the target's node space and should stay 
+     * within its content rect, as positions outside its bounding box are 
+     * culled before the shape is tested. Shapes are immutable and cheap to 
+     * copy, so one shape can be shared by any number of filters
+     */
+    class MOUSEAPI_DLL HitShape {
+    protected:
+        struct AlphaMask {
+            size_t width;
+            size_t height;
+            // One bit per pixel, rows from the bottom up
+            std::vector<uint64_t> bits;
+        };
+
+        HitShapeType m_type = HitShapeType::Bounds;
+        cocos2d::CCPoint m_center;
+        // A radius of 0 is the circle inscribed in the content rect
+        float m_radius = 0.f;
+        std::shared_ptr<std::vector<cocos2d::CCPoint> const> m_points;
+        std::shared_ptr<AlphaMask const> m_mask;
+
+    public:
+        static HitShape bounds();
+        static HitShape rect();
+        /**
+         * The largest circle that fits in the target's content rect
+         */
+        static HitShape circle();
+        static HitShape circle(cocos2d::CCPoint const& center, float radius);
+        /**
+         * A convex polygon, with the points in either winding order
+         */
+        static HitShape polygon(std::vector<cocos2d::CCPoint> points);
+        /**
+         * Pixels of the sprite frame with an alpha of at least threshold, 
+         * stretched over the target's content rect. The frame is rendered 
+         * once to create the mask, so this has to be called on the game 
+         * thread, and it's best to create one mask per frame and share it
+         */
+        static HitShape mask(cocos2d::CCSpriteFrame* frame, uint8_t threshold = 128);
+
+        HitShapeType getType() const;
+        /**
+         * Whether a position in the target's node space is inside the 
+         * shape. Not valid for Bounds, which is tested in the parent's space
+         */
+        bool contains(cocos2d::CCPoint const& pos, cocos2d::CCSize const& size) const;
+    };
+
     static cocos2d::ccTouchType CCTOUCHOTHER = 
         static_cast<cocos2d::ccTouchType>(85);
 
@@ -85,7 +356,12 @@ namespace mouse {
         bool isSwallowed() const;
         cocos2d::CCPoint getPosition() const;
         cocos2d::CCNode* getTarget() const;
+        virtual MouseEventType getType() const = 0;
 
+        /**
+         * Create a touch at the event's position. The caller owns the only 
+         * reference to it and has to release it
+         */
         cocos2d::CCTouch* createTouch() const;
         cocos2d::CCEvent* createEvent() const;
 
@@ -113,6 +389,7 @@ namespace mouse {
 
         MouseButton getButton() const;
         bool isDown() const;
+        MouseEventType getType() const override;
     };
 
     class MOUSEAPI_DLL MouseMoveEvent : public MouseEvent {
@@ -127,12 +404,16 @@ namespace mouse {
             cocos2d::CCNode* target,
             cocos2d::CCPoint const& position
         );
+
+        MouseEventType getType() const override;
     };
     
     class MOUSEAPI_DLL MouseScrollEvent : public MouseEvent {
     protected:
         float m_deltaY;
         float m_deltaX;
+        size_t m_sampleCount = 1;
+        bool m_continuous = false;
 
         void dispatchDefault(cocos2d::CCNode* target, cocos2d::CCTouch* touch) const override;
     
@@ -146,9 +427,33 @@ namespace mouse {
             float deltaY, float deltaX,
             cocos2d::CCPoint const& position
         );
+        MouseScrollEvent(
+            cocos2d::CCNode* target,
+            float deltaY, float deltaX,
+            cocos2d::CCPoint const& position,
+            size_t sampleCount, bool continuous
+        );
 
+        /**
+         * Total scroll delta of all the samples merged into this event
+         */
         float getDeltaY() const;
         float getDeltaX() const;
+        /**
+         * The first scroll message a target receives in a frame is posted 
+         * right away, and the rest of that frame's messages are merged into
+         * a second event at the start of the next scheduler tick. This is 
+         * the number of messages merged into this event, which is 1 for 
+         * the first one
+         */
+        size_t getSampleCount() const;
+        /**
+         * Whether this scroll came from a continuous source like a 
+         * precision touchpad rather than discrete mouse wheel notches, as 
+         * reported by the platform
+         */
+        bool isContinuous() const;
+        MouseEventType getType() const override;
     };
 
     class MOUSEAPI_DLL MouseHoverEvent : public MouseEvent {
@@ -165,6 +470,79 @@ namespace mouse {
 
         bool isEnter() const;
         bool isLeave() const;
+        MouseEventType getType() const override;
+    };
+
+    class MOUSEAPI_DLL MouseDoubleClickEvent : public MouseEvent {
+    protected:
+        MouseButton m_button;
+
+        void dispatchDefault(cocos2d::CCNode* target, cocos2d::CCTouch* touch) const override;
+
+    public:
+        MouseDoubleClickEvent(
+            cocos2d::CCNode* target, MouseButton button,
+            cocos2d::CCPoint const& position
+        );
+
+        MouseButton getButton() const;
+        MouseEventType getType() const override;
+    };
+
+    class MOUSEAPI_DLL MouseLongPressEvent : public MouseEvent {
+    protected:
+        MouseButton m_button;
+
+        void dispatchDefault(cocos2d::CCNode* target, cocos2d::CCTouch* touch) const override;
+
+    public:
+        MouseLongPressEvent(
+            cocos2d::CCNode* target, MouseButton button,
+            cocos2d::CCPoint const& position
+        );
+
+        MouseButton getButton() const;
+        MouseEventType getType() const override;
+    };
+
+    /**
+     * Posted on every move while dragging. MouseDragStartEvent and 
+     * MouseDragEndEvent are posted when the drag starts and ends
+     */
+    class MOUSEAPI_DLL MouseDragEvent : public MouseEvent {
+    protected:
+        MouseButton m_button;
+        cocos2d::CCPoint m_startPosition;
+
+        void dispatchDefault(cocos2d::CCNode* target, cocos2d::CCTouch* touch) const override;
+
+    public:
+        MouseDragEvent(
+            cocos2d::CCNode* target, MouseButton button,
+            cocos2d::CCPoint const& startPosition,
+            cocos2d::CCPoint const& position
+        );
+
+        MouseButton getButton() const;
+        /**
+         * Position where the button was pressed down
+         */
+        cocos2d::CCPoint getStartPosition() const;
+        /**
+         * Distance dragged since the button was pressed down
+         */
+        cocos2d::CCPoint getDelta() const;
+        MouseEventType getType() const override;
+    };
+
+    class MOUSEAPI_DLL MouseDragStartEvent : public MouseDragEvent {
+    public:
+        using MouseDragEvent::MouseDragEvent;
+    };
+
+    class MOUSEAPI_DLL MouseDragEndEvent : public MouseDragEvent {
+    public:
+        using MouseDragEvent::MouseDragEvent;
     };
 
     class MOUSEAPI_DLL MouseEventFilter : public sapphire::EventFilter<MouseEvent> {
@@ -173,6 +551,23 @@ namespace mouse {
         sapphire::Ref<cocos2d::CCTouch> m_eaten = nullptr;
         bool m_ignorePosition = false;
         size_t m_filterIndex = 0;
+        unsigned int m_interest = MOUSE_EVENTS_DEFAULT;
+        PriorityClass m_priorityClass = PriorityClass::Immediate;
+        HitShape m_hitShape;
+        DelegateProxy m_proxy = DelegateProxy::None;
+        bool m_stateful = false;
+
+        void updateStateful(bool hovered);
+        // Clear the target's hover & held state after it ended up beneath a 
+        // modal node, as it won't receive the events that would clear them
+        void occlude(cocos2d::CCPoint const& pos);
+        MouseResult getProxyResult(MouseEvent* event) const;
+        // Whether the position is inside the target, or the target ignores 
+        // positions. The target has to be non-null
+        bool isUnder(cocos2d::CCPoint const& pos) const;
+
+        friend class ::MouseEventListenerPool;
+        friend class ::SceneSnapshot;
 
     public:
         using Callback = MouseResult(MouseEvent*);
@@ -184,18 +579,48 @@ namespace mouse {
          * entire lifetime of the filter!
          */
         MouseEventFilter(cocos2d::CCNode* target, bool ignorePosition = false);
+        /**
+         * Create a delegate proxy filter. Its listener doesn't need a 
+         * callback, and is invoked by the pool without going through one
+         */
+        MouseEventFilter(cocos2d::CCNode* target, DelegateProxy proxy);
         MouseEventFilter(MouseEventFilter const&) = default;
         virtual ~MouseEventFilter();
 
         cocos2d::CCNode* getTarget() const;
         std::vector<int> getTargetPriority() const;
         size_t getFilterIndex() const;
+
+        /**
+         * Only receive events of the given types (a combination of 
+         * MouseEventType flags). Events of other types skip this listener 
+         * without invoking it, which also means its target's hover & held 
+         * state isn't updated from them
+         */
+        void setInterest(unsigned int types);
+        unsigned int getInterest() const;
+        bool isInterestedIn(MouseEventType type) const;
+
+        /**
+         * Deferred listeners receive a copy of the event after it has been 
+         * dispatched, so they can't stop it from reaching other listeners. 
+         * Consecutive move, hover & drag events to a deferred listener are 
+         * coalesced so it only sees the latest one
+         */
+        void setPriorityClass(PriorityClass priority);
+        PriorityClass getPriorityClass() const;
+
+        /**
+         * Set the area of the target that receives events. Defaults to the 
+         * target's bounding box
+         */
+        void setHitShape(HitShape const& shape);
+        HitShape const& getHitShape() const;
+
+        DelegateProxy getDelegateProxy() const;
     };
 
     class MOUSEAPI_DLL Mouse {
-    public:
-        // i'm not gonna bother with friending an objc class
-        std::unordered_set<MouseButton> m_heldButtons;
     protected:
         static inline std::atomic_bool s_updating = false;
 
@@ -211,7 +636,136 @@ namespace mouse {
 
         bool isHeld(MouseButton button) const;
 
+        /**
+         * Get the held buttons, cursor position & scroll totals at once. 
+         * Safe to call from any thread without synchronizing with the game 
+         * thread
+         */
+        static MouseState getState();
+
         static void updateListeners();
+
+        /**
+         * Collects listener registrations while alive and adds them to the 
+         * dispatcher at once when the outermost scope ends, with a single 
+         * reorder. Listeners added inside a scope don't receive events 
+         * until it ends. Scopes can be nested. Entering nodes & creating 
+         * menus are batched automatically
+         */
+        class MOUSEAPI_DLL BatchScope {
+        public:
+            BatchScope();
+            ~BatchScope();
+            BatchScope(BatchScope const&) = delete;
+            BatchScope& operator=(BatchScope const&) = delete;
+        };
+
+        /**
+         * Number of registered mouse listeners
+         */
+        static size_t getListenerCount();
+        /**
+         * Number of listener slots iterated over on dispatch, including 
+         * removed listeners awaiting compaction
+         */
+        static size_t getListenerSlotCount();
+
+        static void setGestureSettings(GestureSettings const& settings);
+        static GestureSettings getGestureSettings();
+
+        /**
+         * Maximum time spent invoking deferred listeners per frame, in 
+         * seconds. At least one queued event is always delivered per frame
+         */
+        static void setDeferredBudget(float seconds);
+        static float getDeferredBudget();
+        static DeferredStats getDeferredStats();
+
+        /**
+         * Get the targets under a point, ordered the same way events are 
+         * dispatched to them, without posting any events. Picking stops at 
+         * the first touch delegate or menu that would swallow the event. 
+         * Callbacks aren't invoked, so it can't stop at ones that would 
+         * swallow from their callback. If a node is capturing the mouse, 
+         * it's the only result as it would receive every event. Useful for 
+         * hover previews in editor tools
+         */
+        static std::vector<cocos2d::CCNode*> pick(
+            cocos2d::CCPoint const& point,
+            size_t maxResults = std::numeric_limits<size_t>::max()
+        );
+        /**
+         * Pick the targets under many points at once
+         */
+        static std::vector<std::vector<cocos2d::CCNode*>> pick(
+            std::vector<cocos2d::CCPoint> const& points,
+            size_t maxResults = std::numeric_limits<size_t>::max()
+        );
+
+        /**
+         * Number of threads used for sorting & hit testing in scenes with 
+         * lots of listeners, including the game thread. Listener callbacks 
+         * are always invoked on the game thread in order. Defaults to 1, 
+         * which doesn't use any worker threads
+         */
+        static void setWorkerThreads(size_t count);
+        static size_t getWorkerThreads();
+
+        /**
+         * The most recent dispatches are recorded in a fixed-size ring 
+         * buffer, which is cheap enough to leave enabled
+         */
+        static void setTimelineEnabled(bool enabled);
+        static bool isTimelineEnabled();
+        /**
+         * Get the recorded dispatches matching a filter, newest first. Can 
+         * be called from any thread
+         */
+        static std::vector<MouseTimelineEntry> queryTimeline(
+            sapphire::utils::MiniFunction<bool(MouseTimelineEntry const&)> filter = nullptr,
+            size_t maxResults = std::numeric_limits<size_t>::max()
+        );
+        /**
+         * Write the recorded dispatches to a CSV file, oldest first
+         */
+        static bool dumpTimeline(std::filesystem::path const& path);
+
+        /**
+         * Get the counters of the mouse event pipeline. These are always 
+         * collected, and cheap enough to do so in production
+         */
+        static MouseStats getStats();
+        static void resetStats();
+
+        /**
+         * Mark a node as modal. While the topmost modal in the scene is 
+         * open, listeners beneath it don't receive any events and aren't 
+         * picked, and the ones that were hovered when it appeared get their 
+         * leave events. Modals inside another modal are ignored. Swallowing 
+         * touch layers registered with a higher priority than menus are 
+         * marked automatically
+         */
+        static void setModal(cocos2d::CCNode* node, bool modal = true);
+        static bool isModal(cocos2d::CCNode* node);
+        /**
+         * Get the modal node currently occluding the nodes beneath it, if any
+         */
+        static cocos2d::CCNode* getModal();
+
+        /**
+         * Get the listeners whose targets have left the running scene 
+         * without being destroyed. Listeners are audited every few frames, 
+         * so very recently detached listeners may be missing
+         */
+        static std::vector<OrphanedListener> auditListeners();
+        /**
+         * Park listeners whose targets have been out of the scene for at 
+         * least this many frames in a cold list, so dispatch doesn't visit 
+         * them anymore. They are added back when their target enters the 
+         * scene again. 0 disables parking, which is the default
+         */
+        static void setOrphanPurgeFrames(unsigned int frames);
+        static unsigned int getOrphanPurgeFrames();
     };
 }
 
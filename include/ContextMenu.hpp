@@ -4,6 +4,7 @@
 #include <Sapphire/DefaultInclude.hpp>
 #include <Sapphire/loader/Dispatch.hpp>
 #include <Sapphire/utils/cocos.hpp>
+#include <array>
 
 namespace mouse {
     struct ContextMenuStyle {
@@ -161,6 +162,33 @@ namespace mouse {
         return ContextMenuBuilder();
     }
 
+    /**
+     * Label for displaying a frequently changing number. The value is 
+     * formatted into a fixed buffer and the label is only updated when the 
+     * text actually changes. A change lays out the whole label again, 
+     * though it reuses the sprites it already has instead of creating new 
+     * nodes
+     */
+    class MOUSEAPI_DLL NumericLabel : public cocos2d::CCNode {
+    protected:
+        static constexpr size_t MAX_LENGTH = 24;
+
+        std::array<char, MAX_LENGTH + 1> m_buffer {};
+        size_t m_length = 0;
+        cocos2d::CCLabelBMFont* m_label = nullptr;
+
+        bool init(std::string const& font);
+
+        void updateText(const char* str, size_t length);
+
+    public:
+        static NumericLabel* create(std::string const& font);
+
+        void setValue(float value);
+        void setColor(cocos2d::ccColor3B const& color);
+        void setOpacity(GLubyte opacity);
+    };
+
     class MOUSEAPI_DLL ContextMenuItem : public cocos2d::CCNode {
     protected:
         ContextMenu* m_parentMenu;
@@ -209,22 +237,35 @@ namespace mouse {
     protected:
         std::string m_text;
         std::string m_eventID;
+        NumericLabel* m_valueLabel = nullptr;
         float m_value = 0.f;
         float m_rate = 1.f;
         float m_precision = .25f;
+        bool m_coalesceEvents = false;
+        bool m_dragEventQueued = false;
 
         bool init(ContextMenu* menu, std::string const& eventID);
 
         void updateText();
+        void updateValueLabel();
+        void postDragEvent();
     
     public:
         static DragMenuItem* create(ContextMenu* menu, std::string const& eventID);
 
         void setText(std::string const& text) override;
 
+        float getPreferredWidth() override;
+        void fitToWidth(float width) override;
+
         void setValue(float value);
         void setRate(float rate);
         void setPrecision(float precision);
+        /**
+         * Post at most one ContextMenuDragEvent per frame with the latest 
+         * value, instead of one for every drag tick
+         */
+        void setCoalesceEvents(bool coalesce);
 
         void drag(float delta) override;
     };
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "API.hpp"
+#include <Sapphire/DefaultInclude.hpp>
+#include <cfloat>
+#include <chrono>
+
+namespace mouse {
+    struct KineticScrollSubscription;
+
+    struct KineticScrollOptions {
+        bool horizontal = false;
+        bool vertical = true;
+        // Velocity added per unit of scroll wheel delta
+        float scrollImpulse = 40.f;
+        // Exponential velocity decay rate per second
+        float friction = 5.f;
+        // Below this speed the motion stops
+        float minVelocity = 2.f;
+        // Whether holding left click and dragging scrolls the node
+        bool drag = true;
+        cocos2d::CCPoint minOffset = { -FLT_MAX, -FLT_MAX };
+        cocos2d::CCPoint maxOffset = { FLT_MAX, FLT_MAX };
+    };
+
+    /**
+     * Inertial scrolling shared by every subscribed node. Each node's
+     * listener only records timestamped scroll & drag samples, while a
+     * single scheduled update integrates the motion of every moving node
+     * with a fixed timestep and reports the new offsets. The update is only
+     * scheduled while some node is moving
+     */
+    class MOUSEAPI_DLL KineticScroll : public cocos2d::CCObject {
+    public:
+        using Callback = void(cocos2d::CCNode* node, cocos2d::CCPoint const& offset);
+
+    protected:
+        using Clock = std::chrono::steady_clock;
+
+        static constexpr float STEP = 1.f / 120.f;
+        static constexpr size_t MAX_STEPS_PER_FRAME = 8;
+        // Drag samples older than this aren't used for the fling velocity
+        static constexpr float SAMPLE_WINDOW = .1f;
+
+        struct DragSample {
+            Clock::time_point time;
+            cocos2d::CCPoint position;
+        };
+
+        struct State {
+            sapphire::utils::MiniFunction<Callback> callback;
+            KineticScrollOptions options;
+            float decayPerStep = 1.f;
+            cocos2d::CCPoint offset;
+            cocos2d::CCPoint velocity;
+            bool dragging = false;
+            bool dirty = false;
+            bool active = false;
+            // Removed while updating, erased once the update is done
+            bool removed = false;
+            cocos2d::CCPoint lastDrag;
+            std::vector<DragSample> samples;
+        };
+
+        std::unordered_map<cocos2d::CCNode*, State> m_states;
+        std::vector<cocos2d::CCNode*> m_active;
+        float m_accumulator = 0.f;
+        bool m_scheduled = false;
+        bool m_updating = false;
+
+        void activate(cocos2d::CCNode* node, State& state);
+        void forget(cocos2d::CCNode* node);
+        MouseResult handle(cocos2d::CCNode* node, MouseEvent* event);
+        cocos2d::CCPoint clampOffset(State& state, cocos2d::CCPoint const& offset);
+
+        friend struct KineticScrollSubscription;
+
+    public:
+        static KineticScroll* get();
+
+        /**
+         * Make a node scroll kinetically. The callback is called at most
+         * once per frame whenever the node's offset changes
+         */
+        void add(
+            cocos2d::CCNode* node,
+            sapphire::utils::MiniFunction<Callback> callback,
+            KineticScrollOptions const& options = KineticScrollOptions()
+        );
+        void remove(cocos2d::CCNode* node);
+
+        /**
+         * Add a scroll impulse to a node, for example from a custom input
+         */
+        void scroll(cocos2d::CCNode* node, cocos2d::CCPoint const& delta);
+        void stop(cocos2d::CCNode* node);
+        bool isScrolling(cocos2d::CCNode* node) const;
+        cocos2d::CCPoint getOffset(cocos2d::CCNode* node) const;
+        void setOffset(cocos2d::CCNode* node, cocos2d::CCPoint const& offset);
+
+        void update(float dt) override;
+    };
+}
@@ -15,5 +15,11 @@ namespace mouse {
         void show(cocos2d::CCPoint const& pos);
         void show(cocos2d::CCNode* node);
         void hide();
+
+        /**
+         * Set how long a node has to be hovered before its tooltip is shown
+         */
+        static void setShowDelay(float seconds);
+        static float getShowDelay();
     };
 }
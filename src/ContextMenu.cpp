@@ -14,23 +14,29 @@ bool ContextMenuItem::init(ContextMenu* menu) {
     m_hoverBG->setColor(to3B(m_parentMenu->getStyle().hoverColor));
     this->addChild(m_hoverBG);
 
-    this->template addEventListener<MouseEventFilter>([this](MouseEvent* event) {
+    auto listener = this->template addEventListener<MouseEventFilter>([this](MouseEvent* event) {
         if (auto click = typeinfo_cast<MouseClickEvent*>(event)) {
-            m_lastDrag = event->getPosition();
             if (click->getButton() == MouseButton::Left && !click->isDown()) {
                 this->select();
             }
         }
-        m_dragged = typeinfo_cast<MouseMoveEvent*>(event);
-        if (m_dragged && MouseAttributes::from(this)->isHeld(MouseButton::Left)) {
-            this->drag(event->getPosition().y - m_lastDrag.y);
-            m_lastDrag = event->getPosition();
+        if (auto drag = typeinfo_cast<MouseDragEvent*>(event)) {
+            if (drag->getButton() == MouseButton::Left) {
+                // include the distance moved before the drag threshold was hit
+                if (typeinfo_cast<MouseDragStartEvent*>(event)) {
+                    m_lastDrag = drag->getStartPosition();
+                }
+                this->drag(event->getPosition().y - m_lastDrag.y);
+                m_lastDrag = event->getPosition();
+                m_dragged = !typeinfo_cast<MouseDragEndEvent*>(event);
+            }
         }
         if (auto scroll = typeinfo_cast<MouseScrollEvent*>(event)) {
             this->drag(-scroll->getDeltaY());
         }
         return MouseResult::Swallow;
     });
+    listener->getFilter().setInterest(MOUSE_EVENTS_DEFAULT | MouseEventType::Drag);
 
     return true;
 }
@@ -146,12 +152,69 @@ void ActionMenuItem::select() {
     m_parentMenu->getTopMostMenu()->hide();
 }
 
+bool NumericLabel::init(std::string const& font) {
+    if (!CCNode::init())
+        return false;
+
+    m_label = CCLabelBMFont::create("", font.c_str());
+    m_label->setAnchorPoint({ .0f, .0f });
+    this->addChild(m_label);
+
+    return true;
+}
+
+NumericLabel* NumericLabel::create(std::string const& font) {
+    auto ret = new NumericLabel();
+    if (ret && ret->init(font)) {
+        ret->autorelease();
+        return ret;
+    }
+    CC_SAFE_DELETE(ret);
+    return nullptr;
+}
+
+void NumericLabel::updateText(const char* str, size_t length) {
+    if (length == m_length && std::equal(str, str + length, m_buffer.data())) {
+        return;
+    }
+    std::copy(str, str + length, m_buffer.data());
+    m_buffer[length] = '\0';
+    m_length = length;
+    // CCLabelBMFont reuses the sprites of its existing characters
+    m_label->setString(m_buffer.data());
+    this->setContentSize(m_label->getContentSize());
+}
+
+void NumericLabel::setValue(float value) {
+    std::array<char, MAX_LENGTH> buffer;
+    auto res = fmt::format_to_n(buffer.data(), buffer.size(), "{}", value);
+    this->updateText(buffer.data(), std::min<size_t>(res.size, buffer.size()));
+}
+
+void NumericLabel::setColor(ccColor3B const& color) {
+    m_label->setColor(color);
+}
+
+void NumericLabel::setOpacity(GLubyte opacity) {
+    m_label->setOpacity(opacity);
+}
+
 bool DragMenuItem::init(ContextMenu* menu, std::string const& eventID) {
     if (!ContextMenuItem::init(menu))
         return false;
 
     m_eventID = eventID;
+
+    auto const& style = menu->getStyle();
+    m_valueLabel = NumericLabel::create(style.fontName);
+    m_valueLabel->setAnchorPoint({ .0f, .5f });
+    m_valueLabel->setColor(to3B(style.textColor));
+    m_valueLabel->setOpacity(style.textColor.a);
+    this->addChild(m_valueLabel);
+
     ContextMenuDragInitEvent(eventID, menu->getTarget(), &m_value).post();
+    this->updateText();
+    this->updateValueLabel();
 
     return true;
 }
@@ -167,21 +230,44 @@ DragMenuItem* DragMenuItem::create(ContextMenu* menu, std::string const& eventID
 }
 
 void DragMenuItem::updateText() {
-    if (!m_label) {
-        this->setText("");
-    }
-    if (m_text.size()) {
-        m_label->setString(fmt::format("{}: {}", m_text, m_value).c_str());
+    m_valueLabel->setValue(m_value);
+}
+
+void DragMenuItem::updateValueLabel() {
+    auto const& style = m_parentMenu->getStyle();
+    // the value is placed right after the text label, which only changes 
+    // when the text or the item width changes
+    if (m_label) {
+        m_valueLabel->setScale(m_label->getScale());
+        m_valueLabel->setPosition(
+            m_label->getPositionX() + m_label->getScaledContentSize().width,
+            style.height / 2
+        );
     }
     else {
-        m_label->setString(fmt::format("{}", m_value).c_str());
+        limitNodeSize(m_valueLabel, {
+            style.maxWidth,
+            style.height - style.padding * 2
+        }, 1.f, .1f);
+        m_valueLabel->setPosition(style.height, style.height / 2);
     }
 }
 
 void DragMenuItem::setText(std::string const& text) {
     m_text = text;
-    ContextMenuItem::setText(text);
-    this->updateText();
+    ContextMenuItem::setText(m_text.size() ? m_text + ": " : "");
+    this->updateValueLabel();
+}
+
+float DragMenuItem::getPreferredWidth() {
+    auto width = ContextMenuItem::getPreferredWidth();
+    this->updateValueLabel();
+    return width + m_valueLabel->getScaledContentSize().width / m_ratio;
+}
+
+void DragMenuItem::fitToWidth(float width) {
+    ContextMenuItem::fitToWidth(width);
+    this->updateValueLabel();
 }
 
 void DragMenuItem::setValue(float value) {
@@ -197,6 +283,10 @@ void DragMenuItem::setPrecision(float precision) {
     m_precision = precision;
 }
 
+void DragMenuItem::setCoalesceEvents(bool coalesce) {
+    m_coalesceEvents = coalesce;
+}
+
 void DragMenuItem::drag(float delta) {
     if (m_precision > .000001f) {
         m_value = roundf((m_value + delta * m_rate) / m_precision) * m_precision;
@@ -205,7 +295,18 @@ void DragMenuItem::drag(float delta) {
         m_value += delta * m_rate;
     }
     this->updateText();
-    ContextMenuDragEvent(m_eventID, m_parentMenu->getTarget(), m_value).post();
+    if (!m_coalesceEvents) {
+        ContextMenuDragEvent(m_eventID, m_parentMenu->getTarget(), m_value).post();
+    }
+    else if (!m_dragEventQueued) {
+        m_dragEventQueued = true;
+        // the menu may be hidden by the time this runs, so hold on to both 
+        // the item and the target
+        Loader::get()->queueInGDThread([self = Ref(this), target = Ref(m_parentMenu->getTarget())]() {
+            self->m_dragEventQueued = false;
+            ContextMenuDragEvent(self->m_eventID, target, self->m_value).post();
+        });
+    }
 }
 
 bool SubMenuItem::init(ContextMenu* menu, json::Value const& json) {
@@ -393,8 +494,13 @@ void ContextMenu::parseItems(json::Value const& value) {
                         static_cast<float>(obj["precision"].as_double())
                     );
                 }
+                if (obj.count("coalesce")) {
+                    static_cast<DragMenuItem*>(item)->setCoalesceEvents(
+                        obj["coalesce"].as_bool()
+                    );
+                }
             } catch(...) {
-                items.push_back(this->createError("Invalid \"drag\", \"value\", or \"rate\""));
+                items.push_back(this->createError("Invalid \"drag\", \"value\", \"rate\", or \"coalesce\""));
                 continue;
             }
         }
@@ -2,23 +2,112 @@
 
 #ifdef SAPPHIRE_IS_DESKTOP
 #include "Platform.hpp"
+#include "FrameUpdate.hpp"
 #include "../include/API.hpp"
+#include "State.hpp"
 #include <Sapphire/modify/CCMouseDispatcher.hpp>
+#include <limits>
 
 using namespace sapphire::prelude;
 using namespace mouse;
 
+// Scroll messages are merged per frame and per target, as precision 
+// touchpads send lots of tiny deltas every frame. The first message for a 
+// target is posted right away so scrolling has no added latency, and the 
+// rest are merged and posted once when the scheduler tick starts
+struct FrameScroll {
+	Ref<CCNode> target;
+	// Whether the first message was consumed. The merged ones go to the 
+	// same listeners, so they report the same result
+	bool consumed = false;
+	float deltaY = 0.f;
+	float deltaX = 0.f;
+	CCPoint position;
+	size_t samples = 0;
+	bool continuous = false;
+};
+
+static std::vector<FrameScroll> s_frameScrolls;
+static bool s_forwarding = false;
+static bool s_precise = false;
+
+void setPreciseScroll(bool precise) {
+	s_precise = precise;
+}
+
+// Posts the scroll and forwards it to the original delegates if nothing
+// swallowed it
+static bool postScroll(
+	CCNode* target, float y, float x, CCPoint const& pos, size_t samples, bool continuous
+) {
+	auto ev = MouseScrollEvent(target, y, x, pos, samples, continuous);
+	postMouseEventThroughTouches(ev, CCTOUCHOTHER);
+	if (ev.isSwallowed()) {
+		return true;
+	}
+	s_forwarding = true;
+	auto res = CCDirector::get()->getMouseDispatcher()->dispatchScrollMSG(y, x);
+	s_forwarding = false;
+	return res;
+}
+
+class ScrollFlusher : public CCObject {
+protected:
+	bool m_scheduled = false;
+
+public:
+	static ScrollFlusher* get() {
+		static auto inst = new ScrollFlusher();
+		return inst;
+	}
+
+	void start() {
+		// before anything else this tick, so the merged deltas are seen in
+		// the same frame they were received
+		startFrameUpdate(this, m_scheduled, std::numeric_limits<int>::min());
+	}
+
+	void update(float) override {
+		auto scrolls = std::move(s_frameScrolls);
+		s_frameScrolls.clear();
+		for (auto& scroll : scrolls) {
+			if (!scroll.samples) continue;
+			postScroll(
+				scroll.target, scroll.deltaY, scroll.deltaX,
+				scroll.position, scroll.samples, scroll.continuous
+			);
+		}
+		stopFrameUpdate(this, m_scheduled);
+	}
+};
+
 struct $modify(CCMouseDispatcher) {
 	bool dispatchScrollMSG(float y, float x) {
-		auto ev = MouseScrollEvent(
-			Mouse::get()->getCapturingNode(), y, x,
-			getMousePos()
+		// merged scrolls that weren't swallowed go to the original delegates
+		if (s_forwarding) {
+			return CCMouseDispatcher::dispatchScrollMSG(y, x);
+		}
+		PointerState::get().scroll(y, x);
+		auto target = Mouse::get()->getCapturingNode();
+		auto pos = getMousePos();
+		auto it = std::find_if(
+			s_frameScrolls.begin(), s_frameScrolls.end(),
+			[&](FrameScroll const& scroll) {
+				return scroll.target.data() == target;
+			}
 		);
-		postMouseEventThroughTouches(ev, CCTOUCHOTHER);
-		if (ev.isSwallowed()) {
-			return true;
+		if (it == s_frameScrolls.end()) {
+			auto consumed = postScroll(target, y, x, pos, 1, s_precise);
+			s_frameScrolls.push_back({ target, consumed });
+			ScrollFlusher::get()->start();
+			return consumed;
 		}
-		return CCMouseDispatcher::dispatchScrollMSG(y, x);
+		it->deltaY += y;
+		it->deltaX += x;
+		it->position = pos;
+		it->samples += 1;
+		it->continuous = it->continuous || s_precise;
+		return it->consumed;
 	}
 };
 
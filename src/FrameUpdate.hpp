@@ -0,0 +1,21 @@
+#pragma once
+#include "../include/API.hpp"
+
+// The tooltip, gesture, scroll & kinetic scroll singletons only need their 
+// update while they have something to do. These schedule and unschedule a 
+// target's update on the director's scheduler, with a flag tracking whether 
+// it's currently scheduled so it's never scheduled twice
+
+inline void startFrameUpdate(cocos2d::CCObject* target, bool& scheduled, int priority = 0) {
+	if (!scheduled) {
+		scheduled = true;
+		cocos2d::CCDirector::get()->getScheduler()->scheduleUpdateForTarget(target, priority, false);
+	}
+}
+
+inline void stopFrameUpdate(cocos2d::CCObject* target, bool& scheduled) {
+	if (scheduled) {
+		scheduled = false;
+		cocos2d::CCDirector::get()->getScheduler()->unscheduleUpdateForTarget(target);
+	}
+}
@@ -0,0 +1,182 @@
+#include "Pool.hpp"
+#include "FrameUpdate.hpp"
+#include <array>
+#include <chrono>
+
+static GestureSettings s_settings;
+
+void Mouse::setGestureSettings(GestureSettings const& settings) {
+	s_settings = settings;
+}
+
+GestureSettings Mouse::getGestureSettings() {
+	return s_settings;
+}
+
+// Recognizes gestures from the raw click & move events once for every
+// listener, instead of every listener that cares about drags or double
+// clicks running its own state machine on every event
+class GestureRecognizer : public CCObject {
+protected:
+	using Clock = std::chrono::steady_clock;
+
+	struct ButtonState {
+		bool down = false;
+		bool dragging = false;
+		bool longPressed = false;
+		bool doubleClicked = false;
+		Clock::time_point pressTime;
+		CCPoint pressPosition;
+		// The node that captured the mouse on press, which all of this
+		// press' gestures are posted to
+		Ref<CCNode> target;
+		// The last press that ended up being a plain click, used for
+		// recognizing double clicks
+		bool clicked = false;
+		Clock::time_point clickTime;
+		CCPoint clickPosition;
+	};
+
+	std::array<ButtonState, 5> m_buttons;
+	CCPoint m_position;
+	bool m_scheduled = false;
+
+	template <class E, class... Args>
+	static void post(MouseEventType type, Args&&... args) {
+		// don't bother creating events no one is listening to
+		if (MouseEventListenerPool::get()->hasInterestIn(type)) {
+			E(std::forward<Args>(args)...).post();
+		}
+	}
+
+	void start() {
+		startFrameUpdate(this, m_scheduled);
+	}
+
+	void stop() {
+		stopFrameUpdate(this, m_scheduled);
+	}
+
+	void press(MouseButton button, CCPoint const& pos) {
+		auto& state = m_buttons[static_cast<size_t>(button)];
+		auto now = Clock::now();
+		bool doubleClick =
+			state.clicked &&
+			std::chrono::duration<float>(now - state.clickTime).count() <= s_settings.doubleClickInterval &&
+			(pos - state.clickPosition).getLength() <= s_settings.doubleClickDistance;
+
+		state = ButtonState();
+		state.down = true;
+		state.pressTime = now;
+		state.pressPosition = pos;
+		state.target = Mouse::get()->getCapturingNode();
+		state.doubleClicked = doubleClick;
+		if (doubleClick) {
+			post<MouseDoubleClickEvent>(
+				MouseEventType::DoubleClick, state.target.data(), button, pos
+			);
+		}
+		if (MouseEventListenerPool::get()->hasInterestIn(MouseEventType::LongPress)) {
+			this->start();
+		}
+	}
+
+	void release(MouseButton button, CCPoint const& pos) {
+		auto& state = m_buttons[static_cast<size_t>(button)];
+		if (!state.down) {
+			return;
+		}
+		state.down = false;
+		if (state.dragging) {
+			post<MouseDragEndEvent>(
+				MouseEventType::Drag, state.target.data(), button, state.pressPosition, pos
+			);
+		}
+		// the second click of a double click doesn't start another one
+		else if (!state.longPressed && !state.doubleClicked) {
+			state.clicked = true;
+			state.clickTime = state.pressTime;
+			state.clickPosition = state.pressPosition;
+		}
+		state.dragging = false;
+		state.target = nullptr;
+	}
+
+	void move(CCPoint const& pos) {
+		m_position = pos;
+		for (size_t i = 0; i < m_buttons.size(); i++) {
+			auto& state = m_buttons[i];
+			if (!state.down) continue;
+			auto button = static_cast<MouseButton>(i);
+			if (state.dragging) {
+				post<MouseDragEvent>(
+					MouseEventType::Drag, state.target.data(), button, state.pressPosition, pos
+				);
+			}
+			else if ((pos - state.pressPosition).getLength() > s_settings.dragThreshold) {
+				state.dragging = true;
+				post<MouseDragStartEvent>(
+					MouseEventType::Drag, state.target.data(), button, state.pressPosition, pos
+				);
+			}
+		}
+	}
+
+public:
+	static GestureRecognizer* get() {
+		static auto inst = new GestureRecognizer();
+		return inst;
+	}
+
+	void feed(MouseEvent const& event) {
+		switch (event.getType()) {
+			case MouseEventType::Click: {
+				auto& click = static_cast<MouseClickEvent const&>(event);
+				if (static_cast<size_t>(click.getButton()) >= m_buttons.size()) {
+					return;
+				}
+				m_position = click.getPosition();
+				if (click.isDown()) {
+					this->press(click.getButton(), click.getPosition());
+				}
+				else {
+					this->release(click.getButton(), click.getPosition());
+				}
+			} break;
+
+			case MouseEventType::Move: {
+				this->move(event.getPosition());
+			} break;
+
+			default: break;
+		}
+	}
+
+	// Only scheduled while a button is held for long press detection
+	void update(float) override {
+		auto now = Clock::now();
+		bool pending = false;
+		for (size_t i = 0; i < m_buttons.size(); i++) {
+			auto& state = m_buttons[i];
+			if (!state.down || state.dragging || state.longPressed) continue;
+			auto held = std::chrono::duration<float>(now - state.pressTime).count();
+			if (held >= s_settings.longPressDelay) {
+				state.longPressed = true;
+				post<MouseLongPressEvent>(
+					MouseEventType::LongPress, state.target.data(),
+					static_cast<MouseButton>(i), m_position
+				);
+			}
+			else {
+				pending = true;
+			}
+		}
+		if (!pending) {
+			this->stop();
+		}
+	}
+};
+
+void recognizeGestures(MouseEvent const& event) {
+	GestureRecognizer::get()->feed(event);
+}
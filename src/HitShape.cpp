@@ -0,0 +1,142 @@
+#include "../include/API.hpp"
+#include <cmath>
+
+using namespace sapphire::prelude;
+using namespace mouse;
+
+HitShape HitShape::bounds() {
+	return HitShape();
+}
+
+HitShape HitShape::rect() {
+	HitShape shape;
+	shape.m_type = HitShapeType::Rect;
+	return shape;
+}
+
+HitShape HitShape::circle() {
+	HitShape shape;
+	shape.m_type = HitShapeType::Circle;
+	return shape;
+}
+
+HitShape HitShape::circle(CCPoint const& center, float radius) {
+	HitShape shape;
+	shape.m_type = HitShapeType::Circle;
+	shape.m_center = center;
+	shape.m_radius = radius;
+	return shape;
+}
+
+HitShape HitShape::polygon(std::vector<CCPoint> points) {
+	HitShape shape;
+	shape.m_type = HitShapeType::Polygon;
+	shape.m_points = std::make_shared<std::vector<CCPoint>>(std::move(points));
+	return shape;
+}
+
+HitShape HitShape::mask(CCSpriteFrame* frame, uint8_t threshold) {
+	HitShape shape;
+	shape.m_type = HitShapeType::Mask;
+	auto mask = std::make_shared<AlphaMask>();
+	mask->width = 0;
+	mask->height = 0;
+	shape.m_mask = mask;
+	if (!frame) {
+		return shape;
+	}
+	// Sprite frames may be trimmed, rotated or packed into an atlas, so
+	// rendering the frame is the simplest way to get its pixels
+	auto size = frame->getOriginalSize();
+	auto sprite = CCSprite::createWithSpriteFrame(frame);
+	auto texture = CCRenderTexture::create(
+		static_cast<int>(std::ceil(size.width)), static_cast<int>(std::ceil(size.height))
+	);
+	if (!sprite || !texture) {
+		return shape;
+	}
+	sprite->setAnchorPoint({ 0.f, 0.f });
+	sprite->setPosition({ 0.f, 0.f });
+	texture->beginWithClear(0.f, 0.f, 0.f, 0.f);
+	sprite->visit();
+	texture->end();
+
+	// not flipped, so the rows go from the bottom up like node space
+	auto image = texture->newCCImage(false);
+	if (!image) {
+		return shape;
+	}
+	auto data = image->getData();
+	mask->width = static_cast<size_t>(image->getWidth());
+	mask->height = static_cast<size_t>(image->getHeight());
+	mask->bits.assign((mask->width * mask->height + 63) / 64, 0);
+	for (size_t i = 0; i < mask->width * mask->height; i++) {
+		// RGBA
+		if (data[i * 4 + 3] >= threshold) {
+			mask->bits[i / 64] |= uint64_t(1) << (i % 64);
+		}
+	}
+	image->release();
+	return shape;
+}
+
+HitShapeType HitShape::getType() const {
+	return m_type;
+}
+
+bool HitShape::contains(CCPoint const& pos, CCSize const& size) const {
+	switch (m_type) {
+		case HitShapeType::Bounds:
+		case HitShapeType::Rect: {
+			return pos.x >= 0.f && pos.y >= 0.f && pos.x <= size.width && pos.y <= size.height;
+		}
+
+		case HitShapeType::Circle: {
+			auto center = m_center;
+			auto radius = m_radius;
+			if (radius <= 0.f) {
+				center = ccp(size.width / 2, size.height / 2);
+				radius = std::min(size.width, size.height) / 2;
+			}
+			auto dx = pos.x - center.x;
+			auto dy = pos.y - center.y;
+			return dx * dx + dy * dy <= radius * radius;
+		}
+
+		case HitShapeType::Polygon: {
+			if (!m_points || m_points->size() < 3) {
+				return false;
+			}
+			// Inside a convex polygon the position is on the same side of
+			// every edge, whichever way the points wind
+			auto const& points = *m_points;
+			bool positive = false;
+			bool negative = false;
+			for (size_t i = 0; i < points.size(); i++) {
+				auto const& a = points[i];
+				auto const& b = points[(i + 1) % points.size()];
+				auto cross = (b.x - a.x) * (pos.y - a.y) - (b.y - a.y) * (pos.x - a.x);
+				positive |= cross > 0.f;
+				negative |= cross < 0.f;
+				if (positive && negative) {
+					return false;
+				}
+			}
+			return true;
+		}
+
+		case HitShapeType::Mask: {
+			if (!m_mask || !m_mask->width || !m_mask->height || size.width <= 0.f || size.height <= 0.f) {
+				return false;
+			}
+			auto x = std::floor(pos.x / size.width * m_mask->width);
+			auto y = std::floor(pos.y / size.height * m_mask->height);
+			if (x < 0.f || y < 0.f || x >= m_mask->width || y >= m_mask->height) {
+				return false;
+			}
+			auto i = static_cast<size_t>(y) * m_mask->width + static_cast<size_t>(x);
+			return m_mask->bits[i / 64] & (uint64_t(1) << (i % 64));
+		}
+	}
+	return false;
+}
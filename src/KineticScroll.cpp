@@ -0,0 +1,283 @@
+#include "../include/KineticScroll.hpp"
+#include "FrameUpdate.hpp"
+#include <Sapphire/utils/ranges.hpp>
+
+using namespace sapphire::prelude;
+using namespace mouse;
+
+// Unsubscribes the node once its listener is destroyed, which happens when 
+// the node itself is destroyed
+struct mouse::KineticScrollSubscription {
+    CCNode* node;
+
+    KineticScrollSubscription(CCNode* node) : node(node) {}
+
+    ~KineticScrollSubscription() {
+        KineticScroll::get()->forget(node);
+    }
+};
+
+KineticScroll* KineticScroll::get() {
+    static auto inst = new KineticScroll();
+    return inst;
+}
+
+void KineticScroll::add(
+    CCNode* node,
+    MiniFunction<Callback> callback,
+    KineticScrollOptions const& options
+) {
+    auto& state = m_states[node];
+    // removed earlier this tick, so it starts over but is still in the 
+    // active list
+    if (state.removed) {
+        auto active = state.active;
+        state = State();
+        state.active = active;
+    }
+    state.callback = callback;
+    state.options = options;
+    state.decayPerStep = std::exp(-options.friction * STEP);
+
+    if (node->getEventListener("kinetic-scroll"_spr)) {
+        return;
+    }
+    auto subscription = std::make_shared<KineticScrollSubscription>(node);
+    auto listener = node->template addEventListener<MouseEventFilter>(
+        "kinetic-scroll"_spr,
+        [subscription](MouseEvent* event) {
+            return KineticScroll::get()->handle(subscription->node, event);
+        }
+    );
+    // hover events aren't needed for anything here
+    listener->getFilter().setInterest(
+        MouseEventType::Click | MouseEventType::Move | MouseEventType::Scroll
+    );
+    Mouse::updateListeners();
+}
+
+void KineticScroll::remove(CCNode* node) {
+    this->forget(node);
+    node->removeEventListener("kinetic-scroll"_spr);
+}
+
+void KineticScroll::forget(CCNode* node) {
+    // the update erases removed nodes after stepping, so it doesn't race 
+    // with nodes removed & added again by the callbacks
+    if (m_updating) {
+        auto it = m_states.find(node);
+        if (it != m_states.end()) {
+            it->second.removed = true;
+        }
+        return;
+    }
+    m_states.erase(node);
+    ranges::remove(m_active, node);
+}
+
+void KineticScroll::activate(CCNode* node, State& state) {
+    if (!state.active) {
+        state.active = true;
+        m_active.push_back(node);
+    }
+    if (!m_scheduled) {
+        m_accumulator = 0.f;
+        startFrameUpdate(this, m_scheduled);
+    }
+}
+
+CCPoint KineticScroll::clampOffset(State& state, CCPoint const& offset) {
+    auto const& opts = state.options;
+    auto clamped = CCPoint {
+        std::clamp(offset.x, opts.minOffset.x, opts.maxOffset.x),
+        std::clamp(offset.y, opts.minOffset.y, opts.maxOffset.y),
+    };
+    // stop moving along an axis once it hits the edge
+    if (clamped.x != offset.x) {
+        state.velocity.x = 0.f;
+    }
+    if (clamped.y != offset.y) {
+        state.velocity.y = 0.f;
+    }
+    return clamped;
+}
+
+MouseResult KineticScroll::handle(CCNode* node, MouseEvent* event) {
+    auto it = m_states.find(node);
+    if (it == m_states.end() || it->second.removed) {
+        return MouseResult::Leave;
+    }
+    auto& state = it->second;
+    auto axes = CCPoint {
+        state.options.horizontal ? 1.f : 0.f,
+        state.options.vertical ? 1.f : 0.f,
+    };
+
+    if (auto scroll = typeinfo_cast<MouseScrollEvent*>(event)) {
+        this->scroll(node, { scroll->getDeltaX(), scroll->getDeltaY() });
+        return MouseResult::Swallow;
+    }
+    if (!state.options.drag) {
+        return MouseResult::Leave;
+    }
+    if (auto click = typeinfo_cast<MouseClickEvent*>(event)) {
+        if (click->getButton() != MouseButton::Left) {
+            return MouseResult::Leave;
+        }
+        if (click->isDown()) {
+            // grabbing the node stops any ongoing motion
+            state.dragging = true;
+            state.velocity = CCPointZero;
+            state.lastDrag = event->getPosition();
+            state.samples.clear();
+            state.samples.push_back({ Clock::now(), event->getPosition() });
+            return MouseResult::Swallow;
+        }
+        if (state.dragging) {
+            state.dragging = false;
+            // fling with the velocity of the most recent drag samples
+            auto now = Clock::now();
+            auto window = std::chrono::duration<float>(SAMPLE_WINDOW);
+            std::erase_if(state.samples, [&](DragSample const& sample) {
+                return now - sample.time > window;
+            });
+            if (state.samples.size() >= 2) {
+                auto const& first = state.samples.front();
+                auto const& last = state.samples.back();
+                auto dt = std::chrono::duration<float>(last.time - first.time).count();
+                if (dt > 0.f) {
+                    auto delta = last.position - first.position;
+                    state.velocity = CCPoint { delta.x * axes.x, delta.y * axes.y } / dt;
+                    this->activate(node, state);
+                }
+            }
+            state.samples.clear();
+            return MouseResult::Swallow;
+        }
+        return MouseResult::Leave;
+    }
+    if (typeinfo_cast<MouseMoveEvent*>(event) && state.dragging) {
+        auto delta = event->getPosition() - state.lastDrag;
+        state.lastDrag = event->getPosition();
+        state.offset = this->clampOffset(state, state.offset + CCPoint {
+            delta.x * axes.x, delta.y * axes.y
+        });
+        state.samples.push_back({ Clock::now(), event->getPosition() });
+        state.dirty = true;
+        this->activate(node, state);
+        return MouseResult::Swallow;
+    }
+    return MouseResult::Leave;
+}
+
+void KineticScroll::scroll(CCNode* node, CCPoint const& delta) {
+    auto it = m_states.find(node);
+    if (it == m_states.end()) {
+        return;
+    }
+    auto& state = it->second;
+    auto const& opts = state.options;
+    if (opts.horizontal) {
+        state.velocity.x += delta.x * opts.scrollImpulse;
+    }
+    if (opts.vertical) {
+        state.velocity.y += delta.y * opts.scrollImpulse;
+    }
+    this->activate(node, state);
+}
+
+void KineticScroll::stop(CCNode* node) {
+    auto it = m_states.find(node);
+    if (it != m_states.end()) {
+        it->second.velocity = CCPointZero;
+    }
+}
+
+bool KineticScroll::isScrolling(CCNode* node) const {
+    auto it = m_states.find(node);
+    if (it == m_states.end()) {
+        return false;
+    }
+    return it->second.dragging || it->second.velocity != CCPointZero;
+}
+
+CCPoint KineticScroll::getOffset(CCNode* node) const {
+    auto it = m_states.find(node);
+    if (it == m_states.end()) {
+        return CCPointZero;
+    }
+    return it->second.offset;
+}
+
+void KineticScroll::setOffset(CCNode* node, CCPoint const& offset) {
+    auto it = m_states.find(node);
+    if (it == m_states.end()) {
+        return;
+    }
+    auto& state = it->second;
+    state.velocity = CCPointZero;
+    state.offset = this->clampOffset(state, offset);
+    state.dirty = true;
+    this->activate(node, state);
+}
+
+void KineticScroll::update(float dt) {
+    // Run the integrator with a fixed timestep so the motion doesn't depend 
+    // on the framerate, capping the steps per frame so a long frame doesn't 
+    // snowball into even longer ones
+    m_accumulator = std::min(m_accumulator + dt, STEP * MAX_STEPS_PER_FRAME);
+    size_t steps = 0;
+    while (m_accumulator >= STEP) {
+        m_accumulator -= STEP;
+        steps += 1;
+    }
+
+    // callbacks may add, remove or scroll nodes
+    m_updating = true;
+    auto active = m_active;
+    for (auto node : active) {
+        auto it = m_states.find(node);
+        if (it == m_states.end() || it->second.removed) {
+            continue;
+        }
+        auto& state = it->second;
+        if (!state.dragging) {
+            for (size_t i = 0; i < steps && state.velocity != CCPointZero; i++) {
+                state.velocity = state.velocity * state.decayPerStep;
+                if (state.velocity.getLength() < state.options.minVelocity) {
+                    state.velocity = CCPointZero;
+                }
+                state.offset = this->clampOffset(state, state.offset + state.velocity * STEP);
+                state.dirty = true;
+            }
+        }
+        if (state.dirty) {
+            state.dirty = false;
+            if (state.callback) {
+                state.callback(node, state.offset);
+            }
+        }
+    }
+
+    m_updating = false;
+
+    // drop nodes that came to rest or were removed
+    std::erase_if(m_active, [this](CCNode* node) {
+        auto it = m_states.find(node);
+        if (it == m_states.end() || it->second.removed) {
+            return true;
+        }
+        auto& state = it->second;
+        if (state.dragging || state.dirty || state.velocity != CCPointZero) {
+            return false;
+        }
+        state.active = false;
+        return true;
+    });
+    std::erase_if(m_states, [](auto const& pair) {
+        return pair.second.removed;
+    });
+    if (m_active.empty()) {
+        stopFrameUpdate(this, m_scheduled);
+    }
+}
@@ -9,6 +9,7 @@
 #import <Sapphire/cocos/platform/mac/EAGLView.h>
 #import <objc/runtime.h>
 #include "Platform.hpp"
+#include "State.hpp"
 
 using namespace sapphire::prelude;
 using namespace mouse;
@@ -59,6 +60,12 @@ static EventType s_originalMouseMoved;
 	// s_originalMouseMoved(self, @selector(mouseMoved:), event);
 	[[MacMouseEvent sharedEvent] moved:event];
 }
+
+static EventType s_originalScrollWheel;
+- (void)scrollWheelHook:(NSEvent*)event {
+	setPreciseScroll([event hasPreciseScrollingDeltas]);
+	s_originalScrollWheel(self, @selector(scrollWheel:), event);
+}
 SAPPHIRE_API_OBJC_SWIZZLE_METHODS(Left, mouse, s_originalMouse)
 SAPPHIRE_API_OBJC_SWIZZLE_METHODS(Right, rightMouse, s_originalRightMouse)
 SAPPHIRE_API_OBJC_SWIZZLE_METHODS(Middle, otherMouse, s_originalOtherMouse)
@@ -76,6 +83,7 @@ method_exchangeImplementations(method##Method, swizzle##Method);
 		Class class_ = NSClassFromString(@"EAGLView");
 
 		SAPPHIRE_API_OBJC_SWIZZLE(mouseMoved, mouseMovedHook, s_originalMouseMoved)
+		SAPPHIRE_API_OBJC_SWIZZLE(scrollWheel, scrollWheelHook, s_originalScrollWheel)
 
 		SAPPHIRE_API_OBJC_SWIZZLE(mouseDragged, mouseDraggedHook, s_originalMouseDragged)
 		SAPPHIRE_API_OBJC_SWIZZLE(mouseDown, mouseDownHook, s_originalMouseDown)
@@ -110,6 +118,7 @@ method_exchangeImplementations(method##Method, swizzle##Method);
 
 	m_xPosition = x / [[NSClassFromString(@"EAGLView") sharedEGLView] frameZoomFactor];
 	m_yPosition = y / [[NSClassFromString(@"EAGLView") sharedEGLView] frameZoomFactor];
+	PointerState::get().move([self getMousePosition]);
 
 	Loader::get()->queueInGDThread([=]() {
 		auto event = MouseMoveEvent(Mouse::get()->getCapturingNode(), [self getMousePosition]);
@@ -124,7 +133,7 @@ method_exchangeImplementations(method##Method, swizzle##Method);
 
 -(void) down:(NSEvent*)event type:(MouseButton)type {
 	[self moved: event];
-	Mouse::get()->m_heldButtons.insert(type);
+	PointerState::get().press(type);
 
 	Loader::get()->queueInGDThread([=]() {
 		auto event = MouseClickEvent(
@@ -143,7 +152,7 @@ method_exchangeImplementations(method##Method, swizzle##Method);
 
 -(void) up:(NSEvent*)event type:(MouseButton)type {
 	[self moved: event];
-	Mouse::get()->m_heldButtons.erase(type);
+	PointerState::get().release(type);
 
 	Loader::get()->queueInGDThread([=]() {
 		auto event = MouseClickEvent(
@@ -5,3 +5,15 @@ using namespace sapphire::prelude;
 using namespace mouse;
 
 void postMouseEventThroughTouches(MouseEvent& event, ccTouchType action);
+
+/**
+ * Called by the platform code before a scroll message is dispatched, with 
+ * whether it came from a precise source like a touchpad instead of wheel 
+ * notches
+ */
+void setPreciseScroll(bool precise);
+
+/**
+ * Feed a raw click or move event to the gesture recognizer
+ */
+void recognizeGestures(MouseEvent const& event);
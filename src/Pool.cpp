@@ -0,0 +1,1333 @@
+#include "Pool.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+
+// Deferred listeners receive the event after the original has gone out of 
+// scope, so they get a copy of it
+static std::shared_ptr<MouseEvent> copyEvent(MouseEvent* event) {
+	if (auto ev = typeinfo_cast<MouseDragStartEvent*>(event)) {
+		return std::make_shared<MouseDragStartEvent>(*ev);
+	}
+	if (auto ev = typeinfo_cast<MouseDragEndEvent*>(event)) {
+		return std::make_shared<MouseDragEndEvent>(*ev);
+	}
+	if (auto ev = typeinfo_cast<MouseDragEvent*>(event)) {
+		return std::make_shared<MouseDragEvent>(*ev);
+	}
+	if (auto ev = typeinfo_cast<MouseDoubleClickEvent*>(event)) {
+		return std::make_shared<MouseDoubleClickEvent>(*ev);
+	}
+	if (auto ev = typeinfo_cast<MouseLongPressEvent*>(event)) {
+		return std::make_shared<MouseLongPressEvent>(*ev);
+	}
+	if (auto ev = typeinfo_cast<MouseClickEvent*>(event)) {
+		return std::make_shared<MouseClickEvent>(*ev);
+	}
+	if (auto ev = typeinfo_cast<MouseMoveEvent*>(event)) {
+		return std::make_shared<MouseMoveEvent>(*ev);
+	}
+	if (auto ev = typeinfo_cast<MouseScrollEvent*>(event)) {
+		return std::make_shared<MouseScrollEvent>(*ev);
+	}
+	if (auto ev = typeinfo_cast<MouseHoverEvent*>(event)) {
+		return std::make_shared<MouseHoverEvent>(*ev);
+	}
+	return nullptr;
+}
+
+// Events that only describe the latest state of the mouse, so an older one 
+// can be replaced by a newer one
+static bool isCoalescable(MouseEvent* event) {
+	switch (event->getType()) {
+		case MouseEventType::Move:
+		case MouseEventType::Hover:
+			return true;
+		case MouseEventType::Drag:
+			return
+				!typeinfo_cast<MouseDragStartEvent*>(event) &&
+				!typeinfo_cast<MouseDragEndEvent*>(event);
+		default:
+			return false;
+	}
+}
+
+static CCNode* getRoot(CCNode* node) {
+	while (auto parent = node->getParent()) {
+		node = parent;
+	}
+	return node;
+}
+
+static CCRect getWorldBounds(CCNode* node) {
+	if (auto parent = node->getParent()) {
+		return CCRectApplyAffineTransform(node->boundingBox(), parent->nodeToWorldTransform());
+	}
+	return node->boundingBox();
+}
+
+bool MouseEventListenerPool::add(EventListenerProtocol* listener) {
+	if (!typeinfo_cast<MouseListener*>(listener)) {
+		return false;
+	}
+	// log::debug("adding {}", &static_cast<MouseListener*>(listener)->getFilter());
+	if (m_batchDepth) {
+		m_batched.push_back(listener);
+	}
+	else if (m_locked) {
+		m_toAdd.push_back(listener);
+	}
+	else {
+		m_listeners.push_back(listener);
+		this->invalidate();
+	}
+	return true;
+}
+
+void MouseEventListenerPool::remove(EventListenerProtocol* listener) {
+	// log::debug("removing {} => {}", &static_cast<MouseListener*>(listener)->getFilter(), listener);
+	if (m_orphans.size()) {
+		auto it = m_orphans.find(listener);
+		if (it != m_orphans.end()) {
+			auto orphan = it->second;
+			m_orphans.erase(it);
+			// parked listeners aren't in m_listeners
+			if (orphan.cold) {
+				auto& cold = m_cold[orphan.target];
+				ranges::remove(cold, listener);
+				if (cold.empty()) {
+					m_cold.erase(orphan.target);
+				}
+				return;
+			}
+		}
+	}
+	this->release(static_cast<MouseListener*>(listener));
+	ranges::remove(m_toAdd, listener);
+	if (m_batched.size()) {
+		ranges::remove(m_batched, listener);
+	}
+	m_deferredResults.erase(listener);
+	if (m_deferred.size()) {
+		m_deferredLast.erase(listener);
+		for (auto& deferred : m_deferred) {
+			if (deferred.listener == listener) {
+				deferred.listener = nullptr;
+			}
+		}
+	}
+
+	size_t index = m_listeners.size();
+	if (!m_recordsDirty) {
+		auto it = m_indices.find(listener);
+		if (it != m_indices.end()) {
+			index = it->second;
+			m_indices.erase(it);
+		}
+	}
+	else {
+		index = std::find(m_listeners.begin(), m_listeners.end(), listener) - m_listeners.begin();
+	}
+	if (index >= m_listeners.size()) {
+		return;
+	}
+
+	// Removed listeners are left as tombstones so the records stay valid 
+	// and removing lots of listeners at once (like when a popup is closed) 
+	// doesn't shift the whole vector for every one of them
+	m_listeners[index] = nullptr;
+	m_tombstones += 1;
+	if (!m_recordsDirty) {
+		if (m_states[index]) {
+			ranges::remove(m_statefulIndices, index);
+		}
+		m_states[index] = 0;
+		m_orphaned[index] = 0;
+	}
+	this->compact();
+}
+
+void MouseEventListenerPool::beginBatch() {
+	m_batchDepth += 1;
+}
+
+void MouseEventListenerPool::endBatch() {
+	if (!m_batchDepth || --m_batchDepth) {
+		return;
+	}
+	if (m_batched.size()) {
+		// added after the current dispatch if there is one
+		auto& target = m_locked ? m_toAdd : m_listeners;
+		target.insert(target.end(), m_batched.begin(), m_batched.end());
+		m_batched.clear();
+		this->invalidate();
+		m_batchNeedsSort = true;
+	}
+	// removals during the batch are compacted at once
+	this->compact();
+	if (m_batchNeedsSort) {
+		m_batchNeedsSort = false;
+		Mouse::updateListeners();
+	}
+}
+
+void MouseEventListenerPool::compact(bool force) {
+	if (m_locked || m_batchDepth || !m_tombstones) {
+		return;
+	}
+	// Only compact once enough of the slots are tombstones, so iterating 
+	// stays proportional to the live listener count without compacting on 
+	// every removal
+	if (
+		!force && (
+			m_tombstones < COMPACT_MIN_TOMBSTONES ||
+			m_tombstones * COMPACT_RATIO <= m_listeners.size()
+		)
+	) {
+		return;
+	}
+	std::erase(m_listeners, nullptr);
+	m_tombstones = 0;
+	this->invalidate();
+}
+
+void MouseEventListenerPool::updateState(EventListenerProtocol* listener) {
+	// the state is read from the filter when the records are rebuilt
+	if (m_recordsDirty) {
+		return;
+	}
+	auto it = m_indices.find(listener);
+	if (it == m_indices.end()) {
+		return;
+	}
+	auto index = it->second;
+	uint8_t state = 0;
+	if (static_cast<MouseListener*>(listener)->getFilter().m_stateful) {
+		state |= STATE_STATEFUL;
+	}
+	if (listener == m_capturing) {
+		state |= STATE_CAPTURING;
+	}
+	if (bool(state) != bool(m_states[index])) {
+		auto pos = std::lower_bound(m_statefulIndices.begin(), m_statefulIndices.end(), index);
+		if (state) {
+			m_statefulIndices.insert(pos, index);
+		}
+		else if (pos != m_statefulIndices.end() && *pos == index) {
+			m_statefulIndices.erase(pos);
+		}
+	}
+	m_states[index] = state;
+}
+
+bool MouseEventListenerPool::prepareHitCache(CCPoint const& pos) {
+	auto frame = CCDirector::get()->getTotalFrames();
+	if (m_hitEpoch != m_epoch || m_hitFrame != frame || pos != m_hitPosition) {
+		// invalidate every entry at once
+		m_hitGeneration += 1;
+		m_hitEpoch = m_epoch;
+		m_hitFrame = frame;
+		m_hitPosition = pos;
+		return true;
+	}
+	return false;
+}
+
+void MouseEventListenerPool::precomputeHits(CCPoint const& pos) {
+	if (!this->prepareHitCache(pos)) {
+		return;
+	}
+	// Once callbacks have moved nodes within a frame, the frame's snapshot 
+	// no longer matches the live nodes. Recapturing it for every event 
+	// would cost more than it saves, so the hits are left to the serial 
+	// path, which tests the live nodes, until the next frame
+	auto frame = CCDirector::get()->getTotalFrames();
+	if (m_snapshot && m_snapshot->getFrame() == frame && m_snapshot->getEpoch() != m_epoch) {
+		return;
+	}
+	// Hit test every listener whose bounds contain the position on the 
+	// workers using the snapshot, so the dispatch walk only reads results
+	auto snapshot = this->getSnapshot();
+	auto const& listeners = snapshot->getListeners();
+	auto generation = m_hitGeneration;
+	WorkerPool::get()->parallelFor(m_listeners.size(), PARALLEL_GRAIN, [&](size_t begin, size_t end) {
+		uint64_t count = 0;
+		for (size_t i = begin; i < end; i++) {
+			if (!m_listeners[i] || !m_targets[i]) continue;
+			if (!(m_flags[i] & FLAG_IGNORE_POSITION) && !listeners[i].bounds.containsPoint(pos)) continue;
+			m_hits[i] = snapshot->contains(i, pos);
+			m_hitStamps[i] = generation;
+			count += 1;
+		}
+		StatCounters::add(StatCounters::get().hitTests, count);
+	});
+}
+
+std::shared_ptr<SceneSnapshot const> MouseEventListenerPool::getSnapshot() {
+	auto frame = CCDirector::get()->getTotalFrames();
+	if (
+		!m_snapshot || m_snapshot->getGeneration() != m_generation ||
+		m_snapshot->getEpoch() != m_epoch || m_snapshot->getFrame() != frame
+	) {
+		m_snapshot = SceneSnapshot::capture(m_listeners, m_generation, m_epoch);
+	}
+	return m_snapshot;
+}
+
+bool MouseEventListenerPool::hitTest(size_t index, MouseEventFilter const& filter, CCPoint const& pos) {
+	this->prepareHitCache(pos);
+	if (m_hitStamps[index] != m_hitGeneration) {
+		m_hitTests += 1;
+		m_hitStamps[index] = m_hitGeneration;
+		m_hits[index] = filter.isUnder(pos);
+	}
+	else {
+		m_hitTestCacheHits += 1;
+	}
+	return m_hits[index];
+}
+
+void MouseEventListenerPool::publishHitStats() {
+	auto& stats = StatCounters::get();
+	if (m_hitTests) {
+		StatCounters::add(stats.hitTests, m_hitTests);
+		m_hitTests = 0;
+	}
+	if (m_hitTestCacheHits) {
+		StatCounters::add(stats.hitTestCacheHits, m_hitTestCacheHits);
+		m_hitTestCacheHits = 0;
+	}
+}
+
+bool MouseEventListenerPool::hitTest(MouseEventFilter const& filter, CCPoint const& pos) {
+	if (!m_recordsDirty && !m_sorting) {
+		auto it = m_indices.find(filter.getListener());
+		if (it != m_indices.end()) {
+			return this->hitTest(it->second, filter, pos);
+		}
+	}
+	m_hitTests += 1;
+	return filter.isUnder(pos);
+}
+
+bool MouseEventListenerPool::hasStatefulListener(size_t begin, size_t end) const {
+	auto it = std::lower_bound(m_statefulIndices.begin(), m_statefulIndices.end(), begin);
+	return it != m_statefulIndices.end() && *it < end;
+}
+
+std::vector<size_t> MouseEventListenerPool::getTargetedIndices(CCNode* target) const {
+	// An event posted to a node only does something for that node's 
+	// listeners and listeners with state, which may be capturing the mouse,
+	// eating it or need to post their leave events. Every other listener 
+	// would just propagate it
+	std::vector<size_t> res;
+	auto it = m_targetIndices.find(target);
+	if (it == m_targetIndices.end()) {
+		return m_statefulIndices;
+	}
+	auto const& indices = it->second;
+	res.reserve(indices.size() + m_statefulIndices.size());
+	std::set_union(
+		indices.begin(), indices.end(),
+		m_statefulIndices.begin(), m_statefulIndices.end(),
+		std::back_inserter(res)
+	);
+	return res;
+}
+
+size_t MouseEventListenerPool::skipCulledGroups(
+	size_t& group, size_t i, CCPoint const& pos, bool keepStateful
+) const {
+	while (group < m_groups.size() && m_groups[group].begin < i) {
+		group += 1;
+	}
+	for (; group < m_groups.size() && m_groups[group].begin == i; group++) {
+		auto const& g = m_groups[group];
+		if (
+			g.cullable && !g.bounds.containsPoint(pos) &&
+			!(keepStateful && this->hasStatefulListener(g.begin, g.end))
+		) {
+			return g.end;
+		}
+	}
+	return i;
+}
+
+void MouseEventListenerPool::rebuildRecords() {
+	auto count = m_listeners.size();
+	m_targets.assign(count, nullptr);
+	m_flags.assign(count, 0);
+	m_interests.assign(count, 0);
+	m_states.assign(count, 0);
+	m_bounds.assign(count, CCRectZero);
+	m_groups.clear();
+	m_indices.clear();
+	m_targetIndices.clear();
+	m_statefulIndices.clear();
+	m_interestMask = 0;
+	m_hitStamps.assign(count, 0);
+	m_hits.assign(count, 0);
+	m_orphaned.assign(count, 0);
+	m_roots.assign(count, nullptr);
+	m_partitions.clear();
+	m_globalEnd = 0;
+	m_partitionScene = nullptr;
+	m_epoch += 1;
+
+	// Forget modals that nothing else holds on to anymore. Of the ones in 
+	// the scene, modals inside another modal are ignored, like a swallowing 
+	// control within a popup, as they would occlude the rest of the popup
+	std::erase_if(m_modals, [](auto const& modal) {
+		return modal->retainCount() <= 1;
+	});
+	auto previousModal = m_activeModal;
+	std::unordered_map<CCNode*, size_t> modalEnds;
+	for (auto const& modal : m_modals) {
+		if (!modal->hasAncestor(nullptr)) continue;
+		bool nested = false;
+		for (auto node = modal->getParent(); node; node = node->getParent()) {
+			if (this->isModal(node)) {
+				nested = true;
+				break;
+			}
+		}
+		if (!nested) {
+			modalEnds.insert({ modal.data(), 0 });
+		}
+	}
+	m_activeModal = nullptr;
+	m_modalEnd = std::numeric_limits<size_t>::max();
+
+	struct OpenGroup {
+		CCNode* node;
+		size_t begin;
+		bool cullable;
+	};
+	std::vector<OpenGroup> open;
+	std::vector<CCNode*> path;
+
+	auto closeGroup = [&](size_t end) {
+		auto group = open.back();
+		open.pop_back();
+		if (!group.cullable && open.size()) {
+			open.back().cullable = false;
+		}
+		// an ancestor with only one child containing listeners covers the
+		// exact same range as that child, so it doesn't need its own group
+		if (
+			m_groups.size() &&
+			m_groups.back().begin == group.begin &&
+			m_groups.back().end == end
+		) {
+			return;
+		}
+		m_groups.push_back({ group.begin, end, group.cullable, CCRectZero });
+	};
+
+	for (size_t i = 0; i < count; i++) {
+		auto listener = static_cast<MouseListener*>(m_listeners[i]);
+		path.clear();
+		if (listener) {
+			auto& filter = listener->getFilter();
+			m_indices[listener] = i;
+			if (m_orphans.size() && m_orphans.contains(listener)) {
+				m_orphaned[i] = 1;
+			}
+			m_targets[i] = filter.getTarget();
+			if (filter.getTarget()) {
+				m_targetIndices[filter.getTarget()].push_back(i);
+			}
+			m_interests[i] = filter.m_interest;
+			m_interestMask |= filter.m_interest;
+			if (!filter.getTarget()) {
+				m_flags[i] |= FLAG_GLOBAL;
+			}
+			if (filter.m_ignorePosition) {
+				m_flags[i] |= FLAG_IGNORE_POSITION;
+			}
+			if (filter.m_priorityClass == PriorityClass::Deferred) {
+				m_flags[i] |= FLAG_DEFERRED;
+			}
+			if (filter.m_proxy != DelegateProxy::None) {
+				m_flags[i] |= FLAG_PROXY;
+			}
+			if (filter.m_proxy == DelegateProxy::MenuChildren) {
+				m_flags[i] |= FLAG_CONTAINER;
+			}
+			if (filter.m_stateful) {
+				m_states[i] |= STATE_STATEFUL;
+			}
+			if (listener == m_capturing) {
+				m_states[i] |= STATE_CAPTURING;
+			}
+			if (m_states[i]) {
+				m_statefulIndices.push_back(i);
+			}
+			for (auto node = filter.getTarget(); node; node = node->getParent()) {
+				path.push_back(node);
+				// a node's descendants are sorted right before it, so the 
+				// modal's listeners end at its last one
+				if (modalEnds.size()) {
+					auto modal = modalEnds.find(node);
+					if (modal != modalEnds.end()) {
+						modal->second = i + 1;
+					}
+				}
+			}
+			std::reverse(path.begin(), path.end());
+			if (path.empty()) {
+				m_globalEnd = i + 1;
+			}
+			else {
+				m_roots[i] = path.front();
+				auto partition = m_partitions.insert({ path.front(), Partition { i, i + 1 } }).first;
+				partition->second.end = i + 1;
+			}
+		}
+		// close the groups of ancestors this listener's target doesn't share
+		// with the previous one and open groups for the new ones. Since
+		// listeners are sorted by their position in the node tree, all
+		// listeners under a common ancestor end up in one range
+		size_t common = 0;
+		while (
+			common < open.size() && common < path.size() &&
+			open[common].node == path[common]
+		) {
+			common += 1;
+		}
+		while (open.size() > common) {
+			closeGroup(i);
+		}
+		for (size_t d = common; d < path.size(); d++) {
+			open.push_back({ path[d], i, true });
+		}
+		if ((m_flags[i] & FLAG_IGNORE_POSITION) && open.size()) {
+			open.back().cullable = false;
+		}
+	}
+	while (open.size()) {
+		closeGroup(count);
+	}
+
+	// groups are closed inner first, but dispatch needs to test outer groups
+	// before inner ones
+	std::sort(m_groups.begin(), m_groups.end(), [](auto const& a, auto const& b) {
+		if (a.begin != b.begin) {
+			return a.begin < b.begin;
+		}
+		return a.end > b.end;
+	});
+
+	// Separate modals don't overlap in dispatch order, so the topmost one 
+	// is the one whose listeners end first
+	for (auto [modal, end] : modalEnds) {
+		if (end && end < m_modalEnd) {
+			m_activeModal = modal;
+			m_modalEnd = end;
+		}
+	}
+	if (m_activeModal && m_activeModal != previousModal) {
+		m_modalSwept = false;
+	}
+
+	m_recordsDirty = false;
+	m_boundsValid = false;
+}
+
+void MouseEventListenerPool::updatePartition() {
+	auto scene = CCDirector::get()->getRunningScene();
+	if (scene == m_partitionScene) {
+		return;
+	}
+	// The new scene's listeners may still be filed under another root, 
+	// like the transition scene they entered through. The partitions are 
+	// rebuilt right away for this event, and if that finds any listeners in
+	// the scene they are sorted out of their old root's range
+	if (!m_partitions.contains(scene)) {
+		this->rebuildRecords();
+		if (m_partitions.contains(scene)) {
+			Mouse::updateListeners();
+		}
+	}
+	m_partitionScene = scene;
+	auto it = m_partitions.find(scene);
+	m_activePartition = it != m_partitions.end() ?
+		it->second :
+		Partition { m_globalEnd, m_globalEnd };
+}
+
+void MouseEventListenerPool::sweepOccluded(CCPoint const& pos) {
+	m_modalSwept = true;
+	// Listeners beneath the modal won't see any more events, so the ones 
+	// that are hovered or holding a touch have to be cleared right away. 
+	// The indices are copied as clearing them updates the stateful indices
+	auto stateful = m_statefulIndices;
+	for (auto index : stateful) {
+		if (!this->isOccluded(index)) continue;
+		auto listener = static_cast<MouseListener*>(m_listeners[index]);
+		if (!listener) continue;
+		this->release(listener);
+		listener->getFilter().occlude(pos);
+	}
+}
+
+void MouseEventListenerPool::auditOrphans() {
+	auto frame = CCDirector::get()->getTotalFrames();
+	m_auditFrame = frame;
+
+	// Whether each node is in the running scene, so nodes sharing ancestors 
+	// don't walk up the same part of the tree again
+	auto scene = CCDirector::get()->getRunningScene();
+	std::unordered_map<CCNode*, bool> inScene;
+	std::vector<CCNode*> chain;
+	auto isInScene = [&](CCNode* node) {
+		chain.clear();
+		bool res = false;
+		for (auto n = node; n; n = n->getParent()) {
+			if (n == scene) {
+				res = true;
+				break;
+			}
+			auto it = inScene.find(n);
+			if (it != inScene.end()) {
+				res = it->second;
+				break;
+			}
+			chain.push_back(n);
+		}
+		for (auto n : chain) {
+			inScene.insert({ n, res });
+		}
+		return res;
+	};
+
+	std::vector<EventListenerProtocol*> expired;
+	for (size_t i = 0; i < m_listeners.size(); i++) {
+		auto listener = m_listeners[i];
+		if (!listener || !m_targets[i]) continue;
+		if (isInScene(m_targets[i])) {
+			if (m_orphaned[i]) {
+				m_orphaned[i] = 0;
+				m_orphans.erase(listener);
+			}
+			continue;
+		}
+		auto [it, inserted] = m_orphans.insert({ listener, Orphan { m_targets[i], frame } });
+		auto& orphan = it->second;
+		// The pool doesn't retain targets, so the class name is captured 
+		// now while the target is known to be alive
+		if (inserted) {
+			orphan.nodeType = getObjectName(m_targets[i]);
+		}
+		m_orphaned[i] = 1;
+		if (m_purgeFrames && frame - orphan.since >= m_purgeFrames) {
+			expired.push_back(listener);
+		}
+	}
+	for (auto listener : expired) {
+		this->park(listener);
+	}
+}
+
+void MouseEventListenerPool::park(EventListenerProtocol* listener) {
+	auto orphan = m_orphans.at(listener);
+	// removing it also forgets it as an orphan
+	this->remove(listener);
+	orphan.cold = true;
+	m_orphans.insert({ listener, orphan });
+	m_cold[orphan.target].push_back(listener);
+}
+
+void MouseEventListenerPool::nodeEntered(CCNode* node) {
+	// A node entering the running scene from another tree, like a layer 
+	// that was built before being added or a scene that entered through a
+	// transition, has its listeners filed under its old root
+	if (!m_recordsDirty) {
+		auto it = m_targetIndices.find(node);
+		if (it != m_targetIndices.end()) {
+			auto scene = CCDirector::get()->getRunningScene();
+			for (auto index : it->second) {
+				if (m_roots[index] != scene) {
+					this->invalidate();
+					Mouse::updateListeners();
+					break;
+				}
+			}
+		}
+	}
+
+	if (m_orphans.empty()) {
+		return;
+	}
+	auto cold = m_cold.find(node);
+	if (cold != m_cold.end()) {
+		auto listeners = std::move(cold->second);
+		m_cold.erase(cold);
+		for (auto listener : listeners) {
+			m_orphans.erase(listener);
+			this->add(listener);
+		}
+		Mouse::updateListeners();
+	}
+	// the node's other listeners aren't orphans anymore either
+	if (!m_recordsDirty) {
+		auto it = m_targetIndices.find(node);
+		if (it != m_targetIndices.end()) {
+			for (auto index : it->second) {
+				if (m_orphaned[index]) {
+					m_orphaned[index] = 0;
+					m_orphans.erase(m_listeners[index]);
+				}
+			}
+		}
+	}
+}
+
+CCTouch* MouseEventListenerPool::getSessionTouch(MouseEvent const* event) {
+	if (!m_sessionTouch || m_sessionDispatch != m_dispatch) {
+		auto touch = event->createTouch();
+		m_sessionTouch = touch;
+		touch->release();
+		m_sessionDispatch = m_dispatch;
+		m_sessionUpdated = 0;
+	}
+	return m_sessionTouch;
+}
+
+void MouseEventListenerPool::updateTouch(CCTouch* touch, MouseEvent const* event) {
+	if (touch == m_sessionTouch) {
+		if (m_sessionUpdated == m_eventDispatch) {
+			return;
+		}
+		m_sessionUpdated = m_eventDispatch;
+	}
+	event->updateTouch(touch);
+}
+
+std::vector<OrphanedListener> MouseEventListenerPool::getOrphans() const {
+	auto frame = CCDirector::get()->getTotalFrames();
+	std::vector<OrphanedListener> res;
+	res.reserve(m_orphans.size());
+	for (auto const& [listener, orphan] : m_orphans) {
+		res.push_back({
+			reinterpret_cast<uintptr_t>(listener),
+			orphan.nodeType,
+			frame - orphan.since,
+			orphan.invocations,
+			orphan.cold,
+		});
+	}
+	// oldest first
+	std::sort(res.begin(), res.end(), [](auto const& a, auto const& b) {
+		return a.age > b.age;
+	});
+	return res;
+}
+
+void MouseEventListenerPool::setModal(CCNode* node, bool modal) {
+	if (!node || this->isModal(node) == modal) {
+		return;
+	}
+	if (modal) {
+		m_modals.push_back(node);
+	}
+	else {
+		std::erase_if(m_modals, [=](auto const& other) {
+			return other == node;
+		});
+	}
+	this->invalidate();
+}
+
+bool MouseEventListenerPool::isModal(CCNode* node) const {
+	return std::any_of(m_modals.begin(), m_modals.end(), [=](auto const& modal) {
+		return modal == node;
+	});
+}
+
+void MouseEventListenerPool::updateBounds() {
+	// Node transforms aren't tracked, so bounds are recomputed once per frame.
+	// A node moved by a callback may use its old bounds for the rest of the
+	// frame, but hovered & eating listeners are never culled so this can't
+	// cause missed leave events
+	auto frame = CCDirector::get()->getTotalFrames();
+	if (m_boundsValid && m_boundsFrame == frame) {
+		return;
+	}
+	m_boundsValid = true;
+	m_boundsFrame = frame;
+
+	auto unionGroups = [this](size_t begin, size_t end) {
+		for (size_t g = begin; g < end; g++) {
+			auto& group = m_groups[g];
+			if (!group.cullable) continue;
+			bool first = true;
+			for (size_t i = group.begin; i < group.end; i++) {
+				if (!m_targets[i] || !m_listeners[i]) continue;
+				group.bounds = first ? m_bounds[i] : unionRects(group.bounds, m_bounds[i]);
+				first = false;
+			}
+		}
+	};
+
+	if (this->isParallel()) {
+		// the snapshot already has the bounds
+		auto snapshot = this->getSnapshot();
+		auto const& listeners = snapshot->getListeners();
+		auto workers = WorkerPool::get();
+		workers->parallelFor(m_targets.size(), PARALLEL_GRAIN, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				if (m_targets[i] && m_listeners[i]) {
+					m_bounds[i] = listeners[i].bounds;
+				}
+			}
+		});
+		workers->parallelFor(m_groups.size(), PARALLEL_GRAIN / 8, unionGroups);
+		return;
+	}
+
+	for (size_t i = 0; i < m_targets.size(); i++) {
+		if (m_targets[i] && m_listeners[i]) {
+			m_bounds[i] = (m_flags[i] & FLAG_CONTAINER) ?
+				this->getContainerBounds(m_targets[i]) :
+				getWorldBounds(m_targets[i]);
+		}
+	}
+	unionGroups(0, m_groups.size());
+}
+
+ListenerResult MouseEventListenerPool::handle(Event* event) {
+	// only MouseEvents use this pool
+	auto mouseEvent = static_cast<MouseEvent*>(event);
+	auto res = ListenerResult::Propagate;
+
+	using Clock = std::chrono::steady_clock;
+	bool record = Timeline::get()->isEnabled();
+	auto start = record ? Clock::now() : Clock::time_point();
+	MouseTimelineEntry entry;
+	uint64_t visited = 0;
+
+	if (m_recordsDirty && !m_sorting) {
+		this->rebuildRecords();
+	}
+	if (
+		!m_locked && !m_recordsDirty && !m_sorting &&
+		CCDirector::get()->getTotalFrames() - m_auditFrame >= AUDIT_INTERVAL
+	) {
+		this->auditOrphans();
+		// parking listeners may have compacted them
+		if (m_recordsDirty) {
+			this->rebuildRecords();
+		}
+	}
+	// the records can't be used while sorting as the listeners are being
+	// moved around
+	bool useRecords = !m_recordsDirty && !m_sorting;
+	// Targeted events have to reach their target wherever it is, so only
+	// untargeted events can skip listeners by position. They are instead 
+	// delivered straight to the target's listeners using the index
+	bool cull = useRecords && !mouseEvent->getTarget();
+	bool targeted = useRecords && mouseEvent->getTarget();
+	std::vector<size_t> targetedIndices;
+	if (targeted) {
+		targetedIndices = this->getTargetedIndices(mouseEvent->getTarget());
+	}
+	auto pos = mouseEvent->getPosition();
+	if (cull) {
+		// may rebuild the records, so it has to come before the bounds
+		this->updatePartition();
+		this->updateBounds();
+		if (this->isParallel()) {
+			this->precomputeHits(pos);
+		}
+	}
+	auto type = static_cast<unsigned int>(mouseEvent->getType());
+
+	auto outerDispatch = m_dispatch;
+	m_dispatch = ++m_dispatchSerial;
+	if (!outerDispatch) {
+		m_eventDispatch = m_dispatch;
+	}
+	m_locked += 1;
+	if (useRecords && !m_modalSwept) {
+		this->sweepOccluded(pos);
+	}
+	size_t group = 0;
+	size_t i = 0;
+	size_t count = targeted ? targetedIndices.size() : m_listeners.size();
+	// Untargeted events only go to the global listeners & the running 
+	// scene's partition, and nothing beneath a modal receives them
+	bool partitioned = useRecords && !targeted;
+	while (i < count) {
+		// Listeners in other scenes or beneath the modal are skipped unless 
+		// they have state, as they may still be capturing the mouse or need 
+		// to post their release & leave events
+		if (
+			partitioned && (
+				this->isOccluded(i) || (
+					i >= m_globalEnd &&
+					(i < m_activePartition.begin || i >= m_activePartition.end)
+				)
+			)
+		) {
+			auto it = std::lower_bound(m_statefulIndices.begin(), m_statefulIndices.end(), i);
+			auto next = it != m_statefulIndices.end() ? *it : count;
+			if (i < m_activePartition.begin && m_activePartition.begin < m_modalEnd) {
+				next = std::min(next, m_activePartition.begin);
+			}
+			if (next != i) {
+				i = next;
+				continue;
+			}
+		}
+		if (cull) {
+			auto next = this->skipCulledGroups(group, i, pos, true);
+			if (next != i) {
+				i = next;
+				continue;
+			}
+		}
+		auto index = targeted ? targetedIndices[i] : i;
+		auto listener = m_listeners[index];
+		i += 1;
+		if (!listener) continue;
+		// nodes beneath a modal still receive events posted to themselves, 
+		// like their hover leave events
+		if (
+			targeted && this->isOccluded(index) &&
+			m_targets[index] != mouseEvent->getTarget()
+		) {
+			continue;
+		}
+		visited += 1;
+		if (useRecords) {
+			if (!(m_interests[index] & type)) {
+				continue;
+			}
+			// A listener that isn't under the cursor and has no state would
+			// just propagate the event, so it doesn't need to be invoked
+			if (
+				cull && !m_states[index] &&
+				!(m_flags[index] & (FLAG_GLOBAL | FLAG_IGNORE_POSITION)) &&
+				!m_bounds[index].containsPoint(pos)
+			) {
+				continue;
+			}
+		}
+		bool deferred = useRecords ?
+			(m_flags[index] & FLAG_DEFERRED) :
+			static_cast<MouseListener*>(listener)->getFilter().m_priorityClass == PriorityClass::Deferred;
+		// the listener may be freed by its own callback
+		auto target = static_cast<MouseListener*>(listener)->getFilter().getTarget();
+		bool swallowed = mouseEvent->isSwallowed();
+		entry.invoked += 1;
+		if (useRecords && m_orphaned[index]) {
+			m_orphans[listener].invocations += 1;
+		}
+		// Delegate proxies have no callback, so their filter is invoked 
+		// directly with the behavior it encodes
+		bool proxy = useRecords ?
+			(m_flags[index] & FLAG_PROXY) :
+			static_cast<MouseListener*>(listener)->getFilter().m_proxy != DelegateProxy::None;
+		ListenerResult result;
+		if (proxy) {
+			result = static_cast<MouseListener*>(listener)->getFilter().handle(nullptr, mouseEvent);
+		}
+		// Only the callback of a deferred listener is deferred. Its filter 
+		// still runs now against the tree the event hit, with the last 
+		// result the callback returned
+		else if (deferred) {
+			result = static_cast<MouseListener*>(listener)->getFilter().handle(
+				[this, listener](MouseEvent* ev) {
+					this->defer(listener, ev);
+					auto it = m_deferredResults.find(listener);
+					return it != m_deferredResults.end() ? it->second : MouseResult::Leave;
+				},
+				mouseEvent
+			);
+		}
+		else {
+			// Delegate proxies & the filters of deferred listeners don't run
+			// any code that could move nodes, so only this invalidates hits
+			m_invokedCallbacks = true;
+			result = listener->handle(event);
+		}
+		if (!swallowed && mouseEvent->isSwallowed()) {
+			entry.swallowedBy = target;
+		}
+		if (result == ListenerResult::Stop) {
+			res = ListenerResult::Stop;
+			break;
+		}
+	}
+	m_locked -= 1;
+	m_dispatch = outerDispatch;
+	// The press has ended, and every listener that shared the touch let go 
+	// of it while handling the release. This may be a nested dispatch, so 
+	// it can't wait for the outermost one to end
+	if (m_sessionTouch && mouseEvent->getType() == MouseEventType::Click) {
+		if (!static_cast<MouseClickEvent*>(mouseEvent)->isDown()) {
+			m_sessionTouch = nullptr;
+		}
+	}
+
+	auto& stats = StatCounters::get();
+	stats.countEvent(mouseEvent->getType());
+	StatCounters::add(stats.listenersVisited, visited);
+	StatCounters::add(stats.listenersInvoked, entry.invoked);
+	this->publishHitStats();
+
+	if (record) {
+		auto end = Clock::now();
+		entry.type = mouseEvent->getType();
+		entry.position = pos;
+		entry.time = std::chrono::duration<double>(start.time_since_epoch()).count();
+		entry.duration = std::chrono::duration<float>(end - start).count();
+		entry.depth = m_locked;
+		entry.swallowed = mouseEvent->isSwallowed();
+		entry.target = mouseEvent->getTarget();
+		entry.capturing = this->getCapturingNode();
+		Timeline::get()->record(entry);
+	}
+
+	if (!m_locked) {
+		// Callbacks may have moved nodes. Nested dispatches keep using the 
+		// cached results until the outermost one is done, and dispatches 
+		// that only reached delegate proxies keep them for the next event
+		if (m_invokedCallbacks) {
+			m_invokedCallbacks = false;
+			this->bumpEpoch();
+		}
+		if (m_toAdd.size()) {
+			for (auto listener : m_toAdd) {
+				m_listeners.push_back(listener);
+			}
+			m_toAdd.clear();
+			this->invalidate();
+		}
+		this->compact();
+	}
+	return res;
+}
+
+std::vector<std::vector<CCNode*>> MouseEventListenerPool::pick(
+	std::vector<CCPoint> const& points, size_t maxResults
+) {
+	std::vector<std::vector<CCNode*>> res(points.size());
+	if (!maxResults) {
+		return res;
+	}
+	// events only reach the capturing node
+	if (auto capturing = this->getCapturingNode()) {
+		for (auto& picked : res) {
+			picked.push_back(capturing);
+		}
+		return res;
+	}
+	// Big batches are picked from the snapshot on the workers
+	if (this->isParallel() && points.size() > 1) {
+		auto snapshot = this->getSnapshot();
+		auto modalEnd = m_recordsDirty ? std::numeric_limits<size_t>::max() : m_modalEnd;
+		WorkerPool::get()->parallelFor(points.size(), 1, [&](size_t begin, size_t end) {
+			for (size_t p = begin; p < end; p++) {
+				res[p] = snapshot->pick(points[p], maxResults, modalEnd);
+			}
+		});
+		return res;
+	}
+	// The records can't be rebuilt mid-dispatch as the dispatch loop is 
+	// using them, but picking still works without them, just slower
+	if (m_recordsDirty && !m_sorting && !m_locked) {
+		this->rebuildRecords();
+	}
+	bool useRecords = !m_recordsDirty && !m_sorting;
+	if (useRecords) {
+		this->updateBounds();
+	}
+
+	// visibility only needs to be checked once per target for every point
+	std::unordered_map<CCNode*, bool> visible;
+	auto isVisible = [&](CCNode* target) {
+		auto it = visible.find(target);
+		if (it == visible.end()) {
+			it = visible.insert({
+				target, nodeIsVisible(target) && target->hasAncestor(nullptr)
+			}).first;
+		}
+		return it->second;
+	};
+
+	auto end = useRecords ? std::min(m_listeners.size(), m_modalEnd) : m_listeners.size();
+	for (size_t p = 0; p < points.size(); p++) {
+		auto const& pos = points[p];
+		auto& picked = res[p];
+		size_t group = 0;
+		size_t i = 0;
+		while (i < end && picked.size() < maxResults) {
+			if (useRecords) {
+				auto next = this->skipCulledGroups(group, i, pos, false);
+				if (next != i) {
+					i = next;
+					continue;
+				}
+			}
+			auto index = i;
+			auto listener = static_cast<MouseListener*>(m_listeners[i]);
+			i += 1;
+			if (!listener) continue;
+			auto& filter = listener->getFilter();
+			auto target = filter.getTarget();
+			// listeners that ignore the position aren't under any point
+			if (!target || filter.m_ignorePosition) continue;
+			if (useRecords && !m_bounds[index].containsPoint(pos)) {
+				continue;
+			}
+			// Touch delegates & menus that swallow stop the event, like they 
+			// would when it's dispatched
+			bool swallows =
+				filter.m_proxy == DelegateProxy::Swallow ||
+				filter.m_proxy == DelegateProxy::MenuChildren;
+			// listeners on the same target are next to each other
+			bool repeated = picked.size() && picked.back() == target;
+			if (repeated && !swallows) continue;
+			if (isVisible(target) && (useRecords ? this->hitTest(index, filter, pos) : this->hitTest(filter, pos))) {
+				if (!repeated) {
+					picked.push_back(target);
+				}
+				if (swallows) {
+					break;
+				}
+			}
+		}
+	}
+	this->publishHitStats();
+	return res;
+}
+
+void MouseEventListenerPool::defer(EventListenerProtocol* listener, MouseEvent* event) {
+	auto copy = copyEvent(event);
+	// events this pool doesn't know how to copy can't be deferred
+	if (!copy) {
+		this->deliver(listener, event);
+		return;
+	}
+	// Replace the listener's last queued event if both only carry the 
+	// latest mouse state. Only the last one is checked so the listener 
+	// still sees events in the order they happened
+	auto last = m_deferredLast.find(listener);
+	if (
+		last != m_deferredLast.end() &&
+		m_deferred[last->second].event->getType() == event->getType() &&
+		isCoalescable(event) && isCoalescable(m_deferred[last->second].event.get())
+	) {
+		m_deferred[last->second].event = copy;
+		m_deferredStats.coalesced += 1;
+		return;
+	}
+	m_deferredLast[listener] = m_deferred.size();
+	m_deferred.push_back({ listener, copy });
+	m_deferredStats.queued += 1;
+	m_deferredStats.peakBacklog = std::max(m_deferredStats.peakBacklog, m_deferred.size());
+
+	if (!m_deferredQueued) {
+		m_deferredQueued = true;
+		Loader::get()->queueInGDThread([this]() {
+			this->processDeferred();
+		});
+	}
+}
+
+void MouseEventListenerPool::deliver(EventListenerProtocol* listener, MouseEvent* event) {
+	// the filter sees it's being delivered and only runs the callback
+	auto delivering = m_delivering;
+	m_delivering = listener;
+	listener->handle(event);
+	m_delivering = delivering;
+	this->bumpEpoch();
+}
+
+void MouseEventListenerPool::processDeferred() {
+	using Clock = std::chrono::steady_clock;
+
+	m_deferredQueued = false;
+	auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+		std::chrono::duration<float>(m_deferredBudget)
+	);
+	// Events queued while processing are left for the next frame, and can't 
+	// be coalesced into ones that are being processed
+	m_deferredLast.clear();
+	auto count = m_deferred.size();
+	size_t i = 0;
+	while (i < count) {
+		if (i > 0 && Clock::now() >= deadline) {
+			break;
+		}
+		// copy the entry as the listener may queue more events
+		auto deferred = m_deferred[i];
+		i += 1;
+		if (!deferred.listener) continue;
+		this->deliver(deferred.listener, deferred.event.get());
+		m_deferredStats.processed += 1;
+	}
+	if (i < count) {
+		m_deferredStats.overBudgetFrames += 1;
+	}
+	// the queue may have been cleared by a listener
+	m_deferred.erase(m_deferred.begin(), m_deferred.begin() + std::min(i, m_deferred.size()));
+
+	m_deferredLast.clear();
+	for (size_t j = 0; j < m_deferred.size(); j++) {
+		if (m_deferred[j].listener) {
+			m_deferredLast[m_deferred[j].listener] = j;
+		}
+	}
+	if (m_deferred.size() && !m_deferredQueued) {
+		m_deferredQueued = true;
+		Loader::get()->queueInGDThread([this]() {
+			this->processDeferred();
+		});
+	}
+}
+
+void MouseEventListenerPool::sortListeners() {
+	// do not allow recursive sorting to happen in any way
+	if (m_sorting) {
+		return;
+	}
+	m_sorting = true;
+	auto start = std::chrono::steady_clock::now();
+	// log::debug("sortListeners");
+	m_locked += 1;
+	// log::debug("sorting");
+	// sort all mouse listeners to put the nodes closer on the screen at the front
+
+	// compute every listener's sort key once up front rather than on every
+	// comparison, as getting the tree indices of a node walks up the whole
+	// tree
+	struct SortEntry {
+		EventListenerProtocol* listener;
+		CCNode* target;
+		CCNode* root;
+		size_t filterIndex;
+		std::vector<int> priority;
+	};
+	std::vector<SortEntry> entries;
+	bool parallel = this->isParallel();
+	if (parallel) {
+		// the sort keys are built from a snapshot on the workers
+		auto snapshot = this->getSnapshot();
+		auto const& listeners = snapshot->getListeners();
+		entries.resize(m_listeners.size());
+		WorkerPool::get()->parallelFor(entries.size(), PARALLEL_GRAIN, [&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				if (!m_listeners[i]) {
+					entries[i] = { nullptr, nullptr, nullptr, 0, {} };
+					continue;
+				}
+				auto const& listener = listeners[i];
+				entries[i] = {
+					m_listeners[i], listener.target, snapshot->getRoot(listener.node),
+					listener.filterIndex, snapshot->getZPath(listener.node)
+				};
+			}
+		});
+	}
+	else {
+		entries.reserve(m_listeners.size());
+		for (auto listener : m_listeners) {
+			if (listener) {
+				auto& filter = static_cast<MouseListener*>(listener)->getFilter();
+				entries.push_back({
+					listener, filter.getTarget(),
+					filter.getTarget() ? getRoot(filter.getTarget()) : nullptr,
+					filter.getFilterIndex(), filter.getTargetPriority()
+				});
+			}
+			else {
+				entries.push_back({ nullptr, nullptr, nullptr, 0, {} });
+			}
+		}
+	}
+	auto compare = [](SortEntry const& a, SortEntry const& b) {
+		// listeners may be null if they are removed mid-handle iteration
+		if (!a.listener || !b.listener) return a.listener > b.listener;
+		// if these listeners point to the same target, compare by which
+		// listener was added first
+		if (a.target == b.target) {
+			return a.filterIndex > b.filterIndex;
+		}
+		// if one of the listeners is global, that comes first
+		if (!a.target) {
+			return true;
+		}
+		if (!b.target) {
+			return false;
+		}
+		// keep every scene's listeners together in one partition
+		if (a.root != b.root) {
+			return std::greater<CCNode*>()(a.root, b.root);
+		}
+		// otherwise compare node tree indices, top nodes top bottom nodes
+		auto& ap = a.priority;
+		auto& bp = b.priority;
+		for (size_t i = 0; i < ap.size(); i++) {
+			if (i < bp.size()) {
+				if (ap[i] != bp[i]) {
+					return ap[i] > bp[i];
+				}
+			}
+		}
+		return ap.size() > bp.size();
+	};
+	if (parallel) {
+		WorkerPool::get()->parallelSort(entries, compare);
+	}
+	else {
+		std::sort(entries.begin(), entries.end(), compare);
+	}
+	for (size_t i = 0; i < entries.size(); i++) {
+		m_listeners[i] = entries[i].listener;
+	}
+	// log::debug("sorting done: {}", m_listeners.size());
+	// for (auto a : m_listeners) {
+		// if (!a) continue;
+		// auto af = static_cast<MouseListener*>(a);
+		// log::debug("{}", &af->getFilter());
+		// log::debug("{}: {}",
+		// 	af->getFilter().getTargetPriority(),
+		// 	af->getFilter().getTarget()
+		// );
+	// }
+	m_locked -= 1;
+	m_sorting = false;
+	this->invalidate();
+	auto& stats = StatCounters::get();
+	StatCounters::add(stats.sorts);
+	StatCounters::add(stats.sortNanoseconds, std::chrono::duration_cast<std::chrono::nanoseconds>(
+		std::chrono::steady_clock::now() - start
+	).count());
+	// tombstones were sorted to the end and the records have to be rebuilt
+	// anyway, so this is a good time to get rid of them
+	this->compact(true);
+}
+
+CCRect MouseEventListenerPool::getContainerBounds(CCNode* container) {
+	auto frame = CCDirector::get()->getTotalFrames();
+	if (m_containerBoundsFrame != frame) {
+		m_containerBounds.clear();
+		m_containerBoundsFrame = frame;
+	}
+	if (m_containerBounds.contains(container)) {
+		return m_containerBounds.at(container);
+	}
+	auto transform = container->nodeToWorldTransform();
+	auto bounds = CCRectZero;
+	bool first = true;
+	for (auto child : CCArrayExt<CCNode>(container->getChildren())) {
+		auto box = CCRectApplyAffineTransform(child->boundingBox(), transform);
+		bounds = first ? box : unionRects(bounds, box);
+		first = false;
+	}
+	m_containerBounds.insert({ container, bounds });
+	return bounds;
+}
@@ -1,3 +1,4 @@
+#pragma once
 #include "../include/API.hpp"
 #include <Sapphire/utils/cocos.hpp>
 #include <Sapphire/utils/ranges.hpp>
@@ -6,6 +7,10 @@
 #include <Sapphire/cocos/robtop/glfw/glfw3.h>
 #include <json/stl_serialize.hpp>
 #include "Platform.hpp"
+#include "Snapshot.hpp"
+#include "Timeline.hpp"
+#include "Stats.hpp"
+#include "WorkerPool.hpp"
 
 using namespace prelude;
 using namespace mouse;
@@ -14,79 +19,319 @@ using MouseListener = EventListener<MouseEventFilter>;
 
 class MouseEventListenerPool : public DefaultEventListenerPool {
 protected:
+	// A contiguous range of listeners in dispatch order whose targets share
+	// a common ancestor, along with the union of their targets' world-space
+	// bounding boxes. If an event is outside the bounds, the whole range
+	// can be skipped with one test
+	struct ListenerGroup {
+		size_t begin;
+		size_t end;
+		// false if any listener in the range doesn't depend on the event
+		// position, i.e. it's global or ignores position
+		bool cullable;
+		cocos2d::CCRect bounds;
+	};
+
+	// Listener record flags
+	static constexpr uint8_t FLAG_GLOBAL = 1 << 0;
+	static constexpr uint8_t FLAG_IGNORE_POSITION = 1 << 1;
+	static constexpr uint8_t FLAG_DEFERRED = 1 << 2;
+	static constexpr uint8_t FLAG_PROXY = 1 << 3;
+	// Menus, whose bounds are the union of their children's
+	static constexpr uint8_t FLAG_CONTAINER = 1 << 4;
+
+	// Listener record state bits
+	static constexpr uint8_t STATE_STATEFUL = 1 << 0;
+	static constexpr uint8_t STATE_CAPTURING = 1 << 1;
+
+	// Compact m_listeners once more than 1 / COMPACT_RATIO of the slots
+	// are tombstones
+	static constexpr size_t COMPACT_RATIO = 4;
+	static constexpr size_t COMPACT_MIN_TOMBSTONES = 8;
+
+	// Sorting & hit testing are split across worker threads only when 
+	// there are enough listeners to be worth the synchronization
+	static constexpr size_t PARALLEL_MIN_LISTENERS = 2048;
+	static constexpr size_t PARALLEL_GRAIN = 512;
+
 	MouseListener* m_capturing = nullptr;
 	std::atomic_bool m_sorting = false;
+	std::vector<EventListenerProtocol*> m_toAdd;
+	// Number of removed listeners still occupying a null slot in m_listeners
+	size_t m_tombstones = 0;
+
+	// Hot per-listener data stored as parallel arrays in dispatch order, so
+	// rejecting listeners that aren't interested in an event or aren't 
+	// under the cursor only touches contiguous memory instead of chasing 
+	// the listener, filter and target pointers
+	std::vector<cocos2d::CCNode*> m_targets;
+	std::vector<uint8_t> m_flags;
+	std::vector<unsigned int> m_interests;
+	std::vector<uint8_t> m_states;
+	// World-space bounds of each target, valid for m_boundsFrame
+	std::vector<cocos2d::CCRect> m_bounds;
+
+	// Listeners are sorted by the scene (or other root node) their target is
+	// in first, so every scene's listeners are one contiguous partition 
+	// after the global listeners. Only the running scene's partition is 
+	// dispatched to, and switching scenes just swaps which one that is
+	struct Partition {
+		size_t begin;
+		size_t end;
+	};
+	std::unordered_map<cocos2d::CCNode*, Partition> m_partitions;
+	// Root of each listener's target when the records were built
+	std::vector<cocos2d::CCNode*> m_roots;
+	// Global listeners are sorted before every partition
+	size_t m_globalEnd = 0;
+	cocos2d::CCNode* m_partitionScene = nullptr;
+	Partition m_activePartition { 0, 0 };
+
+	void updatePartition();
+
+	// Sorted by begin index, with outer groups before inner groups
+	std::vector<ListenerGroup> m_groups;
+	std::unordered_map<EventListenerProtocol*, size_t> m_indices;
+	// Indices of every target's listeners in dispatch order, so events 
+	// posted to a specific node don't need to walk the whole pool
+	std::unordered_map<cocos2d::CCNode*, std::vector<size_t>> m_targetIndices;
+	bool m_recordsDirty = true;
+	// Union of every listener's interest mask
+	unsigned int m_interestMask = 0;
+	unsigned int m_boundsFrame = 0;
+	bool m_boundsValid = false;
+	// Sorted indices of listeners that have to be visited even if the event 
+	// is outside their bounds, because they are hovered, have eaten a touch 
+	// or are capturing the mouse
+	std::vector<size_t> m_statefulIndices;
+
+	std::unordered_map<cocos2d::CCNode*, cocos2d::CCRect> m_containerBounds;
+	unsigned int m_containerBoundsFrame = 0;
+
+	// Whether each target contains the last hit tested position, valid for
+	// entries whose stamp equals m_hitGeneration. Events at the same 
+	// position in the same frame reuse these instead of converting the 
+	// position to every target's node space again, until a callback ran. 
+	// That's mostly the hover events posted mid-dispatch, and events after
+	// one that only reached delegate proxies
+	std::vector<size_t> m_hitStamps;
+	std::vector<uint8_t> m_hits;
+	size_t m_hitGeneration = 1;
+	cocos2d::CCPoint m_hitPosition;
+	size_t m_hitEpoch = 0;
+	unsigned int m_hitFrame = 0;
+	// Bumped whenever the listener records change and after listener 
+	// callbacks ran, as they may have moved nodes. Node transforms aren't 
+	// tracked, so nodes moved by anything else, like actions, are only 
+	// picked up by the cache being stamped per frame
+	size_t m_epoch = 0;
+	bool m_invokedCallbacks = false;
+
+	// Hit tests counted on the game thread since the stats were last 
+	// published, so the hot path doesn't do atomic adds
+	uint64_t m_hitTests = 0;
+	uint64_t m_hitTestCacheHits = 0;
+
+	bool hitTest(size_t index, MouseEventFilter const& filter, cocos2d::CCPoint const& pos);
+	void publishHitStats();
+	bool prepareHitCache(cocos2d::CCPoint const& pos);
+	void precomputeHits(cocos2d::CCPoint const& pos);
+
+	// Read by worker threads in parallel mode instead of the live nodes. 
+	// Recaptured once per frame for the node transforms, whenever the 
+	// listeners change, and after callbacks that may have moved nodes, so 
+	// it matches what dispatch sees on the live nodes
+	std::shared_ptr<SceneSnapshot const> m_snapshot;
+	// Bumped whenever m_listeners is added to, reordered or compacted
+	size_t m_generation = 0;
+
+	bool isParallel() const {
+		return WorkerPool::get()->getThreadCount() > 1 &&
+			m_listeners.size() >= PARALLEL_MIN_LISTENERS;
+	}
+
+	// Events waiting to be delivered to deferred listeners, in dispatch 
+	// order. Removed listeners are nulled out
+	struct DeferredEvent {
+		EventListenerProtocol* listener;
+		std::shared_ptr<MouseEvent> event;
+	};
+	std::vector<DeferredEvent> m_deferred;
+	// Index of each listener's last queued event, for coalescing
+	std::unordered_map<EventListenerProtocol*, size_t> m_deferredLast;
+	// The result each deferred callback returned last, which the dispatch 
+	// uses in place of the callback's
+	std::unordered_map<EventListenerProtocol*, MouseResult> m_deferredResults;
+	// The listener whose callback is being delivered from the queue
+	EventListenerProtocol* m_delivering = nullptr;
+	bool m_deferredQueued = false;
+	float m_deferredBudget = .002f;
+	DeferredStats m_deferredStats;
+
+	void defer(EventListenerProtocol* listener, MouseEvent* event);
+	void deliver(EventListenerProtocol* listener, MouseEvent* event);
+	void processDeferred();
+
+	// Registrations are collected while a Mouse::BatchScope is alive
+	size_t m_batchDepth = 0;
+	std::vector<EventListenerProtocol*> m_batched;
+	bool m_batchNeedsSort = false;
+
+	void compact(bool force = false);
+	void rebuildRecords();
+	void updateBounds();
+	bool hasStatefulListener(size_t begin, size_t end) const;
+	std::vector<size_t> getTargetedIndices(cocos2d::CCNode* target) const;
+
+	// Nodes marked modal, in the order they were marked
+	std::vector<Ref<cocos2d::CCNode>> m_modals;
+	// The topmost modal in the scene that isn't inside another modal, and 
+	// the end of its listeners' range in dispatch order. Listeners after it 
+	// are beneath the modal
+	cocos2d::CCNode* m_activeModal = nullptr;
+	size_t m_modalEnd = std::numeric_limits<size_t>::max();
+	bool m_modalSwept = true;
+
+	void sweepOccluded(cocos2d::CCPoint const& pos);
+
+	// Listeners whose target has been out of the running scene since the 
+	// given frame. Checked every AUDIT_INTERVAL frames
+	struct Orphan {
+		// Only used for identity, as the target may be freed while parked
+		cocos2d::CCNode* target;
+		unsigned int since;
+		std::string nodeType;
+		uint64_t invocations = 0;
+		// Parked in m_cold instead of being in m_listeners
+		bool cold = false;
+	};
+	static constexpr unsigned int AUDIT_INTERVAL = 60;
+	std::unordered_map<EventListenerProtocol*, Orphan> m_orphans;
+	// Parallel to m_listeners, whether the listener is in m_orphans
+	std::vector<uint8_t> m_orphaned;
+	std::unordered_map<cocos2d::CCNode*, std::vector<EventListenerProtocol*>> m_cold;
+	unsigned int m_auditFrame = 0;
+	unsigned int m_purgeFrames = 0;
+
+	void auditOrphans();
+	void park(EventListenerProtocol* listener);
+
+	// Every dispatch, including nested & deferred ones, gets a serial so 
+	// shared state can be updated once per dispatch
+	uint64_t m_dispatch = 0;
+	uint64_t m_dispatchSerial = 0;
+	// Serial of the outermost dispatch. Nested dispatches, like the hover 
+	// events posted during one, belong to the same mouse event
+	uint64_t m_eventDispatch = 0;
+	// The touch shared by every listener that ate the current press. It's 
+	// dropped once a button is released
+	Ref<cocos2d::CCTouch> m_sessionTouch;
+	uint64_t m_sessionDispatch = 0;
+	uint64_t m_sessionUpdated = 0;
+	bool isOccluded(size_t index) const {
+		return index >= m_modalEnd;
+	}
+	size_t skipCulledGroups(size_t& group, size_t i, cocos2d::CCPoint const& pos, bool keepStateful) const;
 
 public:
-	bool add(EventListenerProtocol* listener) override {
-		if (typeinfo_cast<MouseListener*>(listener)) {
-			// log::debug("adding {}", &static_cast<MouseListener*>(listener)->getFilter());
-			return DefaultEventListenerPool::add(listener);
+	bool add(EventListenerProtocol* listener) override;
+	void remove(EventListenerProtocol* listener) override;
+	ListenerResult handle(Event* event) override;
+
+	void sortListeners();
+
+	void beginBatch();
+	void endBatch();
+
+	bool isBatching() const {
+		return m_batchDepth;
+	}
+
+	/**
+	 * Sort the listeners once the current batch ends
+	 */
+	void sortAfterBatch() {
+		m_batchNeedsSort = true;
+	}
+
+	/**
+	 * Get the targets under each point in dispatch order without invoking 
+	 * any listeners
+	 */
+	std::vector<std::vector<cocos2d::CCNode*>> pick(
+		std::vector<cocos2d::CCPoint> const& points, size_t maxResults
+	);
+
+	void setDeferredBudget(float seconds) {
+		m_deferredBudget = seconds;
+	}
+
+	float getDeferredBudget() const {
+		return m_deferredBudget;
+	}
+
+	/**
+	 * Whether a deferred listener's callback is being delivered, in which 
+	 * case its filter should only run the callback and report the result. 
+	 * Only true once per delivery, so events the callback posts are 
+	 * dispatched normally
+	 */
+	bool takeDelivery(EventListenerProtocol* listener) {
+		if (m_delivering && m_delivering == listener) {
+			m_delivering = nullptr;
+			return true;
 		}
 		return false;
 	}
 
-	void remove(EventListenerProtocol* listener) override  {
-		// log::debug("removing {} => {}", &static_cast<MouseListener*>(listener)->getFilter(), listener);
-		this->release(static_cast<MouseListener*>(listener));
-		DefaultEventListenerPool::remove(listener);
+	void setDeferredResult(EventListenerProtocol* listener, MouseResult result) {
+		m_deferredResults[listener] = result;
 	}
 
-	void sortListeners() {
-		// do not allow recursive sorting to happen in any way
-		if (m_sorting) {
-			return;
-		}
-		m_sorting = true;
-		// log::debug("sortListeners");
-		m_locked += 1;
-		// log::debug("sorting");
-		// sort all mouse listeners to put the nodes closer on the screen at the front
-		std::sort(
-			m_listeners.begin(),
-			m_listeners.end(),
-			[](EventListenerProtocol* a, EventListenerProtocol* b) {
-				// listeners may be null if they are removed mid-handle iteration
-				if (!a || !b) return a > b;
-				auto& af = static_cast<MouseListener*>(a)->getFilter();
-				auto& bf = static_cast<MouseListener*>(b)->getFilter();
-				// if these listeners point to the same target, compare by which 
-				// listener was added first
-				if (af.getTarget() == bf.getTarget()) {
-					return af.getFilterIndex() > bf.getFilterIndex();
-				}
-				// if one of the listeners is global, that comes first
-				if (!af.getTarget()) {
-					return true;
-				}
-				if (!bf.getTarget()) {
-					return false;
-				}
-				// otherwise compare node tree indices, top nodes top bottom nodes
-				auto ap = af.getTargetPriority(); 
-				auto bp = bf.getTargetPriority();
-				for (size_t i = 0; i < ap.size(); i++) {
-					if (i < bp.size()) {
-						if (ap[i] != bp[i]) {
-							return ap[i] > bp[i];
-						}
-					}
-				}
-				return ap.size() > bp.size();
-			}
-		);
-		// log::debug("sorting done: {}", m_listeners.size());
-		// for (auto a : m_listeners) {
-			// if (!a) continue;
-			// auto af = static_cast<MouseListener*>(a);
-			// log::debug("{}", &af->getFilter());
-			// log::debug("{}: {}",
-			// 	af->getFilter().getTargetPriority(),
-			// 	af->getFilter().getTarget()
-			// );
-		// }
-		m_locked -= 1;
-		m_sorting = false;
+	void setModal(cocos2d::CCNode* node, bool modal);
+	bool isModal(cocos2d::CCNode* node) const;
+
+	cocos2d::CCNode* getModal() const {
+		return m_activeModal;
+	}
+
+	std::vector<OrphanedListener> getOrphans() const;
+
+	/**
+	 * Get the touch for listeners eating a press. Every listener eating 
+	 * the same press shares one touch
+	 */
+	cocos2d::CCTouch* getSessionTouch(MouseEvent const* event);
+	/**
+	 * Move a listener's touch to the event's position. The shared touch is
+	 * only moved once per outermost dispatch however many listeners hold 
+	 * it, so nested dispatches don't reset its delta
+	 */
+	void updateTouch(cocos2d::CCTouch* touch, MouseEvent const* event);
+
+	void setOrphanPurgeFrames(unsigned int frames) {
+		m_purgeFrames = frames;
+	}
+
+	unsigned int getOrphanPurgeFrames() const {
+		return m_purgeFrames;
+	}
+
+	/**
+	 * Add a node's parked listeners back after it entered the scene, and 
+	 * move its listeners to the running scene's partition
+	 */
+	void nodeEntered(cocos2d::CCNode* node);
+
+	DeferredStats getDeferredStats() const {
+		auto stats = m_deferredStats;
+		stats.backlog = m_deferred.size();
+		return stats;
+	}
+
+	void resetDeferredStats() {
+		m_deferredStats = DeferredStats();
+		m_deferredStats.peakBacklog = m_deferred.size();
 	}
 
     std::vector<MouseListener*> getSortedListeners() {
@@ -105,8 +350,92 @@ public:
         for (auto& l : m_listeners) {
             l = nullptr;
         }
+        m_tombstones = m_listeners.size();
+        m_toAdd.clear();
+        m_batched.clear();
+        m_deferred.clear();
+        m_deferredLast.clear();
+        m_deferredResults.clear();
+        m_modals.clear();
+        m_orphans.clear();
+        m_cold.clear();
+        this->invalidate();
+        this->compact(true);
     }
 
+	/**
+	 * Number of registered listeners, including ones waiting to be added
+	 */
+	size_t getListenerCount() const {
+		auto count = m_listeners.size() - m_tombstones + m_toAdd.size() + m_batched.size();
+		for (auto const& [node, listeners] : m_cold) {
+			count += listeners.size();
+		}
+		return count;
+	}
+
+	/**
+	 * Number of slots iterated over on dispatch, including removed 
+	 * listeners that haven't been compacted away yet
+	 */
+	size_t getSlotCount() const {
+		return m_listeners.size();
+	}
+
+	/**
+	 * Whether any listener may be interested in the given event type, so 
+	 * events nobody wants don't need to be created & posted at all
+	 */
+	bool hasInterestIn(MouseEventType type) const {
+		// be conservative while the records are out of date
+		if (m_recordsDirty || m_toAdd.size() || m_batched.size()) {
+			return true;
+		}
+		return m_interestMask & static_cast<unsigned int>(type);
+	}
+
+	/**
+	 * Get an immutable snapshot of the listeners in dispatch order & the 
+	 * scene data needed for hit testing them, which can be read from any 
+	 * thread. It's recaptured whenever the hit cache's epoch changes. Has 
+	 * to be called on the game thread
+	 */
+	std::shared_ptr<SceneSnapshot const> getSnapshot();
+
+	/**
+	 * Whether a filter's target contains a position, cached for as long as 
+	 * the position and scene don't change
+	 */
+	bool hitTest(MouseEventFilter const& filter, cocos2d::CCPoint const& pos);
+
+	/**
+	 * Invalidate cached hit test results after something in the scene 
+	 * may have changed
+	 */
+	void bumpEpoch() {
+		m_epoch += 1;
+	}
+
+	/**
+	 * Rebuild the listener records & the snapshot before they're next used
+	 */
+	void invalidate() {
+		m_recordsDirty = true;
+		m_generation += 1;
+	}
+
+	/**
+	 * Update a listener's state bits after its filter's stateful flag or
+	 * the capturing listener changed
+	 */
+	void updateState(EventListenerProtocol* listener);
+
+	/**
+	 * Get the world-space union of the bounding boxes of a node's children.
+	 * Computed at most once per frame per container
+	 */
+	cocos2d::CCRect getContainerBounds(cocos2d::CCNode* container);
+
 	MouseListener* getCapturing() const {
 		return m_capturing;
 	}
@@ -122,13 +451,17 @@ public:
 
 	void capture(MouseListener* listener) {
 		if (!m_capturing) {
+			StatCounters::add(StatCounters::get().captures);
 			m_capturing = listener;
+			this->updateState(listener);
 		}
 	}
 
 	void release(MouseListener* listener) {
 		if (m_capturing == listener) {
+			StatCounters::add(StatCounters::get().releases);
 			m_capturing = nullptr;
+			this->updateState(listener);
 		}
 	}
 
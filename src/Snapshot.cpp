@@ -0,0 +1,226 @@
+#include "Snapshot.hpp"
+#include "Pool.hpp"
+
+std::shared_ptr<SceneSnapshot const> SceneSnapshot::capture(
+	std::vector<EventListenerProtocol*> const& listeners,
+	size_t generation, size_t epoch
+) {
+	auto res = std::make_shared<SceneSnapshot>();
+	auto& snapshot = *res;
+	snapshot.m_generation = generation;
+	snapshot.m_epoch = epoch;
+	snapshot.m_frame = CCDirector::get()->getTotalFrames();
+	snapshot.m_listeners.reserve(listeners.size());
+
+	auto scene = CCDirector::get()->getRunningScene();
+	std::unordered_map<CCNode*, int32_t> indices;
+	std::vector<CCNode*> chain;
+	auto addNode = [&](CCNode* node) {
+		// walk up until reaching a node that has already been added
+		chain.clear();
+		int32_t parent = NONE;
+		for (auto n = node; n; n = n->getParent()) {
+			auto it = indices.find(n);
+			if (it != indices.end()) {
+				parent = it->second;
+				break;
+			}
+			chain.push_back(n);
+		}
+		// add the rest top-down so parents come before their children and 
+		// world transforms can be built up one level at a time
+		for (auto it = chain.rbegin(); it != chain.rend(); ++it) {
+			auto n = *it;
+			Node entry;
+			entry.node = n;
+			entry.parent = parent;
+			entry.siblingIndex = 0;
+			entry.box = n->boundingBox();
+			entry.size = n->getContentSize();
+			auto local = n->nodeToParentTransform();
+			if (parent != NONE) {
+				auto const& p = snapshot.m_nodes[parent];
+				entry.world = CCAffineTransformConcat(local, p.world);
+				entry.visible = p.visible && n->isVisible();
+			}
+			else {
+				entry.world = local;
+				// nodes outside the running scene don't receive events
+				entry.visible = n->isVisible() && n == scene;
+			}
+			entry.worldInverse = CCAffineTransformInvert(entry.world);
+			parent = static_cast<int32_t>(snapshot.m_nodes.size());
+			indices.insert({ n, parent });
+			snapshot.m_nodes.push_back(entry);
+		}
+		// this is now the index of the node itself
+		return parent;
+	};
+
+	for (auto listener : listeners) {
+		if (!listener) {
+			snapshot.m_listeners.push_back({ nullptr, NONE, 0, false, CCRectZero, HitShape(), DelegateProxy::None, {} });
+			continue;
+		}
+		auto& filter = static_cast<MouseListener*>(listener)->getFilter();
+		snapshot.m_listeners.push_back({
+			filter.getTarget(),
+			addNode(filter.getTarget()),
+			filter.getFilterIndex(),
+			filter.m_ignorePosition,
+			CCRectZero,
+			filter.m_hitShape,
+			filter.m_proxy,
+			{},
+		});
+		auto& entry = snapshot.m_listeners.back();
+		if (entry.isContainer() && entry.target) {
+			for (auto child : CCArrayExt<CCNode>(entry.target->getChildren())) {
+				entry.children.push_back(child->boundingBox());
+			}
+		}
+	}
+
+	// Find every node's index in its parent with one pass over each parent's
+	// children instead of searching the children for every node
+	std::vector<bool> isParent(snapshot.m_nodes.size());
+	for (auto const& node : snapshot.m_nodes) {
+		if (node.parent != NONE) {
+			isParent[node.parent] = true;
+		}
+	}
+	for (size_t i = 0; i < snapshot.m_nodes.size(); i++) {
+		if (!isParent[i]) continue;
+		int32_t index = 0;
+		for (auto child : CCArrayExt<CCNode>(snapshot.m_nodes[i].node->getChildren())) {
+			auto it = indices.find(child);
+			if (it != indices.end()) {
+				snapshot.m_nodes[it->second].siblingIndex = index;
+			}
+			index += 1;
+		}
+	}
+
+	// The rest only reads the snapshot itself, so it can be split across
+	// the workers
+	WorkerPool::get()->parallelFor(
+		snapshot.m_listeners.size(), 512,
+		[&](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++) {
+				auto& listener = snapshot.m_listeners[i];
+				if (listener.node == NONE) continue;
+				auto const& node = snapshot.m_nodes[listener.node];
+				if (listener.isContainer()) {
+					listener.bounds = CCRectZero;
+					for (size_t c = 0; c < listener.children.size(); c++) {
+						auto box = CCRectApplyAffineTransform(listener.children[c], node.world);
+						listener.bounds = c ? unionRects(listener.bounds, box) : box;
+					}
+					continue;
+				}
+				listener.bounds = node.parent != NONE ?
+					CCRectApplyAffineTransform(node.box, snapshot.m_nodes[node.parent].world) :
+					node.box;
+			}
+		}
+	);
+	return res;
+}
+
+size_t SceneSnapshot::getGeneration() const {
+	return m_generation;
+}
+
+size_t SceneSnapshot::getEpoch() const {
+	return m_epoch;
+}
+
+unsigned int SceneSnapshot::getFrame() const {
+	return m_frame;
+}
+
+auto SceneSnapshot::getNodes() const -> std::vector<Node> const& {
+	return m_nodes;
+}
+
+auto SceneSnapshot::getListeners() const -> std::vector<Listener> const& {
+	return m_listeners;
+}
+
+std::vector<int> SceneSnapshot::getZPath(int32_t node) const {
+	std::vector<int> path;
+	if (node == NONE) {
+		return path;
+	}
+	for (auto n = node; m_nodes[n].parent != NONE; n = m_nodes[n].parent) {
+		path.push_back(m_nodes[n].siblingIndex);
+	}
+	std::reverse(path.begin(), path.end());
+	return path;
+}
+
+CCNode* SceneSnapshot::getRoot(int32_t node) const {
+	if (node == NONE) {
+		return nullptr;
+	}
+	auto n = node;
+	while (m_nodes[n].parent != NONE) {
+		n = m_nodes[n].parent;
+	}
+	return m_nodes[n].node;
+}
+
+bool SceneSnapshot::isVisible(size_t listener) const {
+	auto node = m_listeners[listener].node;
+	return node != NONE && m_nodes[node].visible;
+}
+
+bool SceneSnapshot::contains(size_t listener, CCPoint const& pos) const {
+	auto const& l = m_listeners[listener];
+	if (l.node == NONE) {
+		return false;
+	}
+	if (l.ignorePosition) {
+		return true;
+	}
+	auto const& n = m_nodes[l.node];
+	if (l.isContainer()) {
+		if (!l.bounds.containsPoint(pos)) {
+			return false;
+		}
+		auto local = CCPointApplyAffineTransform(pos, n.worldInverse);
+		return std::any_of(l.children.begin(), l.children.end(), [&](CCRect const& child) {
+			return child.containsPoint(local);
+		});
+	}
+	if (n.parent == NONE) {
+		return false;
+	}
+	if (l.shape.getType() == HitShapeType::Bounds) {
+		return n.box.containsPoint(CCPointApplyAffineTransform(pos, m_nodes[n.parent].worldInverse));
+	}
+	return l.shape.contains(CCPointApplyAffineTransform(pos, n.worldInverse), n.size);
+}
+
+std::vector<CCNode*> SceneSnapshot::pick(CCPoint const& pos, size_t maxResults, size_t end) const {
+	std::vector<CCNode*> picked;
+	end = std::min(end, m_listeners.size());
+	for (size_t i = 0; i < end && picked.size() < maxResults; i++) {
+		auto const& listener = m_listeners[i];
+		// listeners that ignore the position aren't under any point
+		if (!listener.target || listener.ignorePosition) continue;
+		if (!listener.bounds.containsPoint(pos)) continue;
+		// listeners on the same target are next to each other
+		bool repeated = picked.size() && picked.back() == listener.target;
+		if (repeated && !listener.swallows()) continue;
+		if (this->isVisible(i) && this->contains(i, pos)) {
+			if (!repeated) {
+				picked.push_back(listener.target);
+			}
+			if (listener.swallows()) {
+				break;
+			}
+		}
+	}
+	return picked;
+}
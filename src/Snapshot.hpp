@@ -0,0 +1,106 @@
+#pragma once
+#include "../include/API.hpp"
+#include <algorithm>
+#include <memory>
+
+inline cocos2d::CCRect unionRects(cocos2d::CCRect const& a, cocos2d::CCRect const& b) {
+	auto minX = std::min(a.getMinX(), b.getMinX());
+	auto minY = std::min(a.getMinY(), b.getMinY());
+	auto maxX = std::max(a.getMaxX(), b.getMaxX());
+	auto maxY = std::max(a.getMaxY(), b.getMaxY());
+	return cocos2d::CCRect(minX, minY, maxX - minX, maxY - minY);
+}
+
+// An immutable copy of the listener-relevant scene data, with the listeners
+// in dispatch order. It's taken on the game thread, after which it never 
+// touches any cocos objects, so it can be shared with worker threads and 
+// kept around for as long as needed
+class SceneSnapshot {
+public:
+	static constexpr int32_t NONE = -1;
+
+	struct Node {
+		// Only used for identity, never dereferenced after capturing
+		cocos2d::CCNode* node;
+		int32_t parent;
+		// Index in the parent's children
+		int32_t siblingIndex;
+		// Whether the node and all of its ancestors are visible and it's 
+		// in the running scene
+		bool visible;
+		// Bounding box in the parent's space
+		cocos2d::CCRect box;
+		cocos2d::CCSize size;
+		cocos2d::CCAffineTransform world;
+		cocos2d::CCAffineTransform worldInverse;
+	};
+
+	struct Listener {
+		// Only used for identity, never dereferenced after capturing
+		cocos2d::CCNode* target;
+		int32_t node;
+		size_t filterIndex;
+		bool ignorePosition;
+		// World-space bounds of the target
+		cocos2d::CCRect bounds;
+		mouse::HitShape shape;
+		mouse::DelegateProxy proxy;
+		// Bounding boxes of a menu's items in the menu's space, which are 
+		// hit tested instead of the menu itself
+		std::vector<cocos2d::CCRect> children;
+
+		bool isContainer() const {
+			return proxy == mouse::DelegateProxy::MenuChildren;
+		}
+
+		/**
+		 * Whether events that hit this listener stop there
+		 */
+		bool swallows() const {
+			return proxy == mouse::DelegateProxy::Swallow || this->isContainer();
+		}
+	};
+
+protected:
+	// Every listener target and their ancestors, parents before children
+	std::vector<Node> m_nodes;
+	// Parallel to the listeners the snapshot was taken from
+	std::vector<Listener> m_listeners;
+	size_t m_generation = 0;
+	size_t m_epoch = 0;
+	unsigned int m_frame = 0;
+
+public:
+	static std::shared_ptr<SceneSnapshot const> capture(
+		std::vector<sapphire::EventListenerProtocol*> const& listeners,
+		size_t generation, size_t epoch
+	);
+
+	size_t getGeneration() const;
+	size_t getEpoch() const;
+	unsigned int getFrame() const;
+	std::vector<Node> const& getNodes() const;
+	std::vector<Listener> const& getListeners() const;
+
+	/**
+	 * Same as MouseEventFilter::getTargetPriority
+	 */
+	std::vector<int> getZPath(int32_t node) const;
+	/**
+	 * The topmost ancestor of a node, usually the scene it's in
+	 */
+	cocos2d::CCNode* getRoot(int32_t node) const;
+	bool isVisible(size_t listener) const;
+	/**
+	 * Same as MouseEventFilter::isUnder
+	 */
+	bool contains(size_t listener, cocos2d::CCPoint const& pos) const;
+	/**
+	 * Same as MouseEventListenerPool::pick when nothing is capturing. 
+	 * Listeners from end onwards are beneath a modal node and not picked
+	 */
+	std::vector<cocos2d::CCNode*> pick(
+		cocos2d::CCPoint const& pos, size_t maxResults,
+		size_t end = std::numeric_limits<size_t>::max()
+	) const;
+};
@@ -0,0 +1,72 @@
+#include "State.hpp"
+
+using namespace sapphire::prelude;
+using namespace mouse;
+
+static uint32_t buttonBit(MouseButton button) {
+	auto index = static_cast<uint32_t>(button);
+	return index < 32 ? uint32_t(1) << index : 0;
+}
+
+PointerState& PointerState::get() {
+	static auto inst = new PointerState();
+	return *inst;
+}
+
+void PointerState::press(MouseButton button) {
+	this->write([&] {
+		m_buttons.fetch_or(buttonBit(button), std::memory_order_relaxed);
+	});
+}
+
+void PointerState::release(MouseButton button) {
+	this->write([&] {
+		m_buttons.fetch_and(~buttonBit(button), std::memory_order_relaxed);
+	});
+}
+
+void PointerState::move(CCPoint const& pos) {
+	this->write([&] {
+		m_x.store(pos.x, std::memory_order_relaxed);
+		m_y.store(pos.y, std::memory_order_relaxed);
+	});
+}
+
+void PointerState::scroll(float y, float x) {
+	// only this function writes the accumulators, and it's inside the 
+	// write section, so a plain load & store is enough
+	this->write([&] {
+		m_scrollY.store(m_scrollY.load(std::memory_order_relaxed) + y, std::memory_order_relaxed);
+		m_scrollX.store(m_scrollX.load(std::memory_order_relaxed) + x, std::memory_order_relaxed);
+	});
+}
+
+bool PointerState::isHeld(MouseButton button) const {
+	// a single word, so there's nothing to keep consistent with
+	return m_buttons.load(std::memory_order_acquire) & buttonBit(button);
+}
+
+MouseState PointerState::read() const {
+	constexpr auto relaxed = std::memory_order_relaxed;
+
+	MouseState state;
+	while (true) {
+		auto seq = m_sequence.load(std::memory_order_acquire);
+		if (seq % 2) {
+			continue;
+		}
+		state.buttons = m_buttons.load(relaxed);
+		state.position = ccp(m_x.load(relaxed), m_y.load(relaxed));
+		state.scrollX = m_scrollX.load(relaxed);
+		state.scrollY = m_scrollY.load(relaxed);
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (m_sequence.load(relaxed) == seq) {
+			state.sequence = seq / 2;
+			return state;
+		}
+	}
+}
+
+MouseState Mouse::getState() {
+	return PointerState::get().read();
+}
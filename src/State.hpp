@@ -0,0 +1,42 @@
+#pragma once
+#include "../include/API.hpp"
+#include <atomic>
+
+// The global pointer state, published under a sequence lock so any thread 
+// can copy a consistent snapshot without locking or going through the game 
+// thread. Writes are a handful of stores, so readers rarely have to retry
+class PointerState {
+protected:
+	// odd while an update is being written
+	std::atomic<uint64_t> m_sequence = 0;
+	std::atomic<uint32_t> m_buttons = 0;
+	std::atomic<float> m_x = 0.f;
+	std::atomic<float> m_y = 0.f;
+	std::atomic<float> m_scrollX = 0.f;
+	std::atomic<float> m_scrollY = 0.f;
+
+	template <class F>
+	void write(F&& fn) {
+		auto seq = m_sequence.load(std::memory_order_relaxed);
+		// platform callbacks may come from more than one thread
+		while (seq % 2 || !m_sequence.compare_exchange_weak(
+			seq, seq + 1, std::memory_order_acquire, std::memory_order_relaxed
+		)) {
+			seq = m_sequence.load(std::memory_order_relaxed);
+		}
+		std::atomic_thread_fence(std::memory_order_release);
+		fn();
+		m_sequence.store(seq + 2, std::memory_order_release);
+	}
+
+public:
+	static PointerState& get();
+
+	void press(mouse::MouseButton button);
+	void release(mouse::MouseButton button);
+	void move(cocos2d::CCPoint const& pos);
+	void scroll(float y, float x);
+
+	bool isHeld(mouse::MouseButton button) const;
+	mouse::MouseState read() const;
+};
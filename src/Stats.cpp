@@ -0,0 +1,57 @@
+#include "Stats.hpp"
+#include <bit>
+
+using namespace mouse;
+
+StatCounters& StatCounters::get() {
+	static auto inst = new StatCounters();
+	return *inst;
+}
+
+void StatCounters::countEvent(MouseEventType type) {
+	auto index = static_cast<size_t>(std::countr_zero(static_cast<unsigned int>(type)));
+	if (index < events.size()) {
+		add(events[index]);
+	}
+}
+
+MouseStats StatCounters::read() const {
+	constexpr auto relaxed = std::memory_order_relaxed;
+
+	MouseStats stats;
+	for (size_t i = 0; i < events.size(); i++) {
+		stats.events[i] = events[i].load(relaxed);
+	}
+	stats.listenersVisited = listenersVisited.load(relaxed);
+	stats.listenersInvoked = listenersInvoked.load(relaxed);
+	stats.hitTests = hitTests.load(relaxed);
+	stats.hitTestCacheHits = hitTestCacheHits.load(relaxed);
+	stats.hoverEnters = hoverEnters.load(relaxed);
+	stats.hoverLeaves = hoverLeaves.load(relaxed);
+	stats.captures = captures.load(relaxed);
+	stats.releases = releases.load(relaxed);
+	stats.sorts = sorts.load(relaxed);
+	stats.sortTime = sortNanoseconds.load(relaxed) / 1e9;
+	stats.attributeAllocations = attributeAllocations.load(relaxed);
+	stats.touchAllocations = touchAllocations.load(relaxed);
+	stats.touchesAlive = touchesAlive.load(relaxed);
+	return stats;
+}
+
+void StatCounters::reset() {
+	for (auto& counter : events) {
+		counter = 0;
+	}
+	listenersVisited = 0;
+	listenersInvoked = 0;
+	hitTests = 0;
+	hitTestCacheHits = 0;
+	hoverEnters = 0;
+	hoverLeaves = 0;
+	captures = 0;
+	releases = 0;
+	sorts = 0;
+	sortNanoseconds = 0;
+	attributeAllocations = 0;
+	touchAllocations = 0;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include "../include/API.hpp"
+#include <array>
+#include <atomic>
+
+// Always-on counters for the dispatch pipeline. Hot loops count into locals
+// and add them here once per dispatch, so the cost is a handful of relaxed
+// atomic adds per event
+struct StatCounters {
+	using Counter = std::atomic<uint64_t>;
+
+	std::array<Counter, mouse::MOUSE_EVENT_TYPE_COUNT> events {};
+	Counter listenersVisited = 0;
+	Counter listenersInvoked = 0;
+	Counter hitTests = 0;
+	Counter hitTestCacheHits = 0;
+	Counter hoverEnters = 0;
+	Counter hoverLeaves = 0;
+	Counter captures = 0;
+	Counter releases = 0;
+	Counter sorts = 0;
+	Counter sortNanoseconds = 0;
+	Counter attributeAllocations = 0;
+	Counter touchAllocations = 0;
+	// Not reset, as it describes the current state
+	Counter touchesAlive = 0;
+
+	static StatCounters& get();
+
+	static void add(Counter& counter, uint64_t amount = 1) {
+		counter.fetch_add(amount, std::memory_order_relaxed);
+	}
+
+	static void sub(Counter& counter, uint64_t amount = 1) {
+		counter.fetch_sub(amount, std::memory_order_relaxed);
+	}
+
+	void countEvent(mouse::MouseEventType type);
+	mouse::MouseStats read() const;
+	void reset();
+};
@@ -0,0 +1,113 @@
+#include "Timeline.hpp"
+#include <fstream>
+
+using namespace sapphire::prelude;
+using namespace mouse;
+
+static char const* getTypeName(MouseEventType type) {
+	switch (type) {
+		case MouseEventType::Click: return "click";
+		case MouseEventType::Move: return "move";
+		case MouseEventType::Scroll: return "scroll";
+		case MouseEventType::Hover: return "hover";
+		case MouseEventType::DoubleClick: return "double-click";
+		case MouseEventType::LongPress: return "long-press";
+		case MouseEventType::Drag: return "drag";
+		default: return "unknown";
+	}
+}
+
+Timeline* Timeline::get() {
+	static auto inst = new Timeline();
+	return inst;
+}
+
+void Timeline::setEnabled(bool enabled) {
+	m_enabled = enabled;
+}
+
+bool Timeline::isEnabled() const {
+	return m_enabled.load(std::memory_order_relaxed);
+}
+
+void Timeline::record(MouseTimelineEntry const& entry) {
+	constexpr auto relaxed = std::memory_order_relaxed;
+
+	auto index = m_head.fetch_add(1, relaxed);
+	auto& slot = m_slots[index % CAPACITY];
+	slot.seq.store(index * 2 + 1, relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+	slot.type.store(entry.type, relaxed);
+	slot.x.store(entry.position.x, relaxed);
+	slot.y.store(entry.position.y, relaxed);
+	slot.time.store(entry.time, relaxed);
+	slot.duration.store(entry.duration, relaxed);
+	slot.depth.store(entry.depth, relaxed);
+	slot.invoked.store(entry.invoked, relaxed);
+	slot.swallowed.store(entry.swallowed, relaxed);
+	slot.target.store(entry.target, relaxed);
+	slot.swallowedBy.store(entry.swallowedBy, relaxed);
+	slot.capturing.store(entry.capturing, relaxed);
+	slot.seq.store(index * 2 + 2, std::memory_order_release);
+}
+
+bool Timeline::read(uint64_t index, MouseTimelineEntry& entry) const {
+	constexpr auto relaxed = std::memory_order_relaxed;
+
+	auto const& slot = m_slots[index % CAPACITY];
+	auto seq = slot.seq.load(std::memory_order_acquire);
+	// being written or already overwritten by a newer entry
+	if (seq != index * 2 + 2) {
+		return false;
+	}
+	entry.index = index;
+	entry.type = slot.type.load(relaxed);
+	entry.position = ccp(slot.x.load(relaxed), slot.y.load(relaxed));
+	entry.time = slot.time.load(relaxed);
+	entry.duration = slot.duration.load(relaxed);
+	entry.depth = slot.depth.load(relaxed);
+	entry.invoked = slot.invoked.load(relaxed);
+	entry.swallowed = slot.swallowed.load(relaxed);
+	entry.target = slot.target.load(relaxed);
+	entry.swallowedBy = slot.swallowedBy.load(relaxed);
+	entry.capturing = slot.capturing.load(relaxed);
+	std::atomic_thread_fence(std::memory_order_acquire);
+	return slot.seq.load(relaxed) == seq;
+}
+
+std::vector<MouseTimelineEntry> Timeline::query(
+	MiniFunction<bool(MouseTimelineEntry const&)> const& filter,
+	size_t maxResults
+) const {
+	std::vector<MouseTimelineEntry> res;
+	auto head = m_head.load(std::memory_order_acquire);
+	auto tail = head > CAPACITY ? head - CAPACITY : 0;
+	for (auto index = head; index > tail && res.size() < maxResults; index--) {
+		MouseTimelineEntry entry;
+		if (!this->read(index - 1, entry)) continue;
+		if (filter && !filter(entry)) continue;
+		res.push_back(entry);
+	}
+	return res;
+}
+
+bool Timeline::dump(std::filesystem::path const& path) const {
+	std::ofstream file(path);
+	if (!file) {
+		return false;
+	}
+	file << "index,type,x,y,time,duration,depth,invoked,swallowed,target,swallowedBy,capturing\n";
+	auto entries = this->query(nullptr, CAPACITY);
+	for (auto it = entries.rbegin(); it != entries.rend(); ++it) {
+		file << fmt::format(
+			"{},{},{},{},{:.6f},{:.6f},{},{},{},{},{},{}\n",
+			it->index, getTypeName(it->type),
+			it->position.x, it->position.y,
+			it->time, it->duration, it->depth, it->invoked, it->swallowed,
+			static_cast<void*>(it->target),
+			static_cast<void*>(it->swallowedBy),
+			static_cast<void*>(it->capturing)
+		);
+	}
+	return static_cast<bool>(file);
+}
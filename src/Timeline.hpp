@@ -0,0 +1,51 @@
+#pragma once
+#include "../include/API.hpp"
+#include <array>
+#include <atomic>
+
+// Fixed-size ring buffer of recent dispatches. Each slot is guarded by a
+// sequence number, so readers on any thread can copy entries without
+// locking and discard ones that were overwritten while being read
+class Timeline {
+public:
+	static constexpr size_t CAPACITY = 1024;
+
+protected:
+	struct Slot {
+		// 2n + 1 while entry n is being written, 2n + 2 once it's done
+		std::atomic<uint64_t> seq = 0;
+		std::atomic<mouse::MouseEventType> type;
+		std::atomic<float> x;
+		std::atomic<float> y;
+		std::atomic<double> time;
+		std::atomic<float> duration;
+		std::atomic<uint32_t> depth;
+		std::atomic<uint32_t> invoked;
+		std::atomic<bool> swallowed;
+		std::atomic<cocos2d::CCNode*> target;
+		std::atomic<cocos2d::CCNode*> swallowedBy;
+		std::atomic<cocos2d::CCNode*> capturing;
+	};
+
+	std::array<Slot, CAPACITY> m_slots;
+	std::atomic<uint64_t> m_head = 0;
+	std::atomic_bool m_enabled = true;
+
+	bool read(uint64_t index, mouse::MouseTimelineEntry& entry) const;
+
+public:
+	static Timeline* get();
+
+	void setEnabled(bool enabled);
+	bool isEnabled() const;
+
+	void record(mouse::MouseTimelineEntry const& entry);
+	/**
+	 * Newest entries first
+	 */
+	std::vector<mouse::MouseTimelineEntry> query(
+		sapphire::utils::MiniFunction<bool(mouse::MouseTimelineEntry const&)> const& filter,
+		size_t maxResults
+	) const;
+	bool dump(std::filesystem::path const& path) const;
+};
@@ -1,4 +1,5 @@
 #include "../include/Tooltip.hpp"
+#include "FrameUpdate.hpp"
 
 using namespace sapphire::prelude;
 using namespace mouse;
@@ -67,6 +68,104 @@ void Tooltip::hide() {
     this->removeFromParent();
 }
 
+static float s_showDelay = .25f;
+
+void Tooltip::setShowDelay(float seconds) {
+    s_showDelay = seconds;
+}
+
+float Tooltip::getShowDelay() {
+    return s_showDelay;
+}
+
+// Handles showing and moving the tooltip for all tooltip-bearing nodes with 
+// a single scheduled update. Sweeping the cursor across many nodes only 
+// retargets the pending node instead of creating a tooltip per node, and 
+// moves are applied at most once per frame. The update is only scheduled 
+// while there is something to do
+class TooltipScheduler : public CCObject {
+protected:
+    Ref<CCNode> m_hovered = nullptr;
+    Ref<Tooltip> m_tooltip = nullptr;
+    CCPoint m_pos;
+    float m_hoverTime = 0.f;
+    bool m_moved = false;
+    bool m_scheduled = false;
+
+    void start() {
+        startFrameUpdate(this, m_scheduled);
+    }
+
+    void stop() {
+        stopFrameUpdate(this, m_scheduled);
+    }
+
+    void hideTooltip() {
+        if (m_tooltip) {
+            m_tooltip->hide();
+            m_tooltip = nullptr;
+        }
+    }
+
+public:
+    static TooltipScheduler* get() {
+        static auto inst = new TooltipScheduler();
+        return inst;
+    }
+
+    void hover(CCNode* node, CCPoint const& pos) {
+        m_pos = pos + ccp(5.f, 0.f);
+        if (m_hovered.data() != node) {
+            this->hideTooltip();
+            m_hovered = node;
+            m_hoverTime = 0.f;
+            m_moved = false;
+            this->start();
+        }
+        else if (m_tooltip) {
+            m_moved = true;
+            this->start();
+        }
+    }
+
+    void leave(CCNode* node) {
+        if (m_hovered.data() == node) {
+            this->hideTooltip();
+            m_hovered = nullptr;
+            this->stop();
+        }
+    }
+
+    void update(float dt) override {
+        // the node may have been removed without a hover leave event
+        if (!m_hovered || !nodeIsVisible(m_hovered) || !m_hovered->hasAncestor(nullptr)) {
+            this->hideTooltip();
+            m_hovered = nullptr;
+            this->stop();
+            return;
+        }
+        if (!m_tooltip) {
+            m_hoverTime += dt;
+            if (m_hoverTime < s_showDelay) {
+                return;
+            }
+            if (auto value = m_hovered->template getAttribute<std::string>("tooltip"_spr)) {
+                m_tooltip = Tooltip::create(value.value());
+                m_tooltip->show(m_pos);
+            }
+        }
+        else if (m_moved) {
+            m_tooltip->move(m_pos);
+        }
+        m_moved = false;
+        // keep checking whether the node is still there while the tooltip 
+        // is shown, and stop once there's nothing left to do
+        if (!m_tooltip) {
+            this->stop();
+        }
+    }
+};
+
 $execute {
     new EventListener<AttributeSetFilter>(
         +[](AttributeSetEvent* event) {
@@ -77,19 +176,11 @@ $execute {
             node->template addEventListener<MouseEventFilter>(
                 "tooltip"_spr,
                 [=](MouseEvent* event) {
-                    auto tip = static_cast<Tooltip*>(CCScene::get()->getChildByID("tooltip"_spr));
                     if (MouseAttributes::from(node)->isHovered()) {
-                        if (tip) {
-                            tip->move(event->getPosition() + ccp(5.f, 0.));
-                        }
-                        else {
-                            if (auto value = node->template getAttribute<std::string>("tooltip"_spr)) {
-                                Tooltip::create(value.value())->show(event->getPosition() + ccp(5.f, 0.));
-                            }
-                        }
+                        TooltipScheduler::get()->hover(node, event->getPosition());
                     }
-                    else if (tip) {
-                        tip->hide();
+                    else {
+                        TooltipScheduler::get()->leave(node);
                     }
                     return MouseResult::Eat;
                 }
@@ -4,6 +4,8 @@
 #include <Sapphire/cocos/robtop/glfw/glfw3.h>
 #include "../include/API.hpp"
 #include "Platform.hpp"
+#include "State.hpp"
+#include <cmath>
 
 using namespace sapphire::prelude;
 using namespace mouse;
@@ -71,10 +73,13 @@ static CCPoint convertMouseCoords(double x, double y) {
 #include <Sapphire/modify/CCEGLView.hpp>
 
 static GLFWcursorposfun originalCursorPosFun = nullptr;
+static GLFWscrollfun originalScrollFun = nullptr;
 
 void __cdecl glfwPosCallback(GLFWwindow* window, double x, double y) {
 	originalCursorPosFun(window, x, y);
-    auto event = MouseMoveEvent(Mouse::get()->getCapturingNode(), convertMouseCoords(x, y));
+    auto pos = convertMouseCoords(x, y);
+    PointerState::get().move(pos);
+    auto event = MouseMoveEvent(Mouse::get()->getCapturingNode(), pos);
     postMouseEventThroughTouches(
         event,
         (Mouse::get()->isHeld(MouseButton::Left) ?
@@ -83,12 +88,24 @@ void __cdecl glfwPosCallback(GLFWwindow* window, double x, double y) {
     );
 }
 
+void __cdecl glfwScrollCallback(GLFWwindow* window, double x, double y) {
+    // GLFW has no precise flag, but it reports wheel notches as whole 
+    // steps before GD scales them, while touchpads report fractions
+    setPreciseScroll(x != std::floor(x) || y != std::floor(y));
+	originalScrollFun(window, x, y);
+}
+
 void setCursorPosCallback(GLFWwindow* window) {
 	if (!originalCursorPosFun) {
 		originalCursorPosFun = reinterpret_cast<_GLFWwindow*>(window)->callbacks.cursorPos;
 		reinterpret_cast<_GLFWwindow*>(window)->callbacks.cursorPos
 		= reinterpret_cast<GLFWcursorposfun>(&glfwPosCallback);
 	}
+	if (!originalScrollFun) {
+		originalScrollFun = reinterpret_cast<_GLFWwindow*>(window)->callbacks.scroll;
+		reinterpret_cast<_GLFWwindow*>(window)->callbacks.scroll
+		= reinterpret_cast<GLFWscrollfun>(&glfwScrollCallback);
+	}
 }
 
 $on_mod(Loaded) {
@@ -105,10 +122,10 @@ struct $modify(CCEGLViewModify, CCEGLView) {
 
 	void onGLFWMouseCallBack(GLFWwindow* window, int button, int action, int mods) {
         if (action) {
-            Mouse::get()->m_heldButtons.insert(static_cast<MouseButton>(button));
+            PointerState::get().press(static_cast<MouseButton>(button));
         }
         else {
-            Mouse::get()->m_heldButtons.erase(static_cast<MouseButton>(button));
+            PointerState::get().release(static_cast<MouseButton>(button));
         }
         auto event = MouseClickEvent(
             Mouse::get()->getCapturingNode(),
@@ -0,0 +1,102 @@
+#include "WorkerPool.hpp"
+#include <algorithm>
+
+WorkerPool* WorkerPool::get() {
+	static auto inst = new WorkerPool();
+	return inst;
+}
+
+WorkerPool::~WorkerPool() {
+	this->stop();
+}
+
+void WorkerPool::stop() {
+	{
+		std::lock_guard lock(m_mutex);
+		m_stopping = true;
+	}
+	m_wake.notify_all();
+	for (auto& thread : m_threads) {
+		thread.join();
+	}
+	m_threads.clear();
+	m_stopping = false;
+}
+
+void WorkerPool::setThreadCount(size_t count) {
+	count = std::max<size_t>(count, 1);
+	if (count == this->getThreadCount()) {
+		return;
+	}
+	this->stop();
+	// Workers start from the current job, read before they're started. A 
+	// worker reading it itself could miss a job posted before it got to run
+	// and never report it done
+	size_t seen = 0;
+	{
+		std::lock_guard lock(m_mutex);
+		seen = m_jobID;
+	}
+	// the game thread counts as one of the threads
+	for (size_t i = 1; i < count; i++) {
+		m_threads.emplace_back(&WorkerPool::run, this, seen);
+	}
+}
+
+size_t WorkerPool::getThreadCount() const {
+	return m_threads.size() + 1;
+}
+
+void WorkerPool::run(size_t seen) {
+	while (true) {
+		{
+			std::unique_lock lock(m_mutex);
+			m_wake.wait(lock, [&] { return m_stopping || m_jobID != seen; });
+			if (m_stopping) {
+				return;
+			}
+			seen = m_jobID;
+		}
+		this->work();
+		{
+			std::lock_guard lock(m_mutex);
+			m_pendingWorkers -= 1;
+		}
+		m_done.notify_one();
+	}
+}
+
+void WorkerPool::work() {
+	while (true) {
+		auto begin = m_next.fetch_add(m_grain);
+		if (begin >= m_count) {
+			break;
+		}
+		m_job(begin, std::min(begin + m_grain, m_count));
+	}
+}
+
+void WorkerPool::parallelFor(size_t count, size_t grain, Job fn) {
+	grain = std::max<size_t>(grain, 1);
+	// not worth waking up the workers for
+	if (m_threads.empty() || count <= grain) {
+		if (count) {
+			fn(0, count);
+		}
+		return;
+	}
+	{
+		std::lock_guard lock(m_mutex);
+		m_job = std::move(fn);
+		m_count = count;
+		m_grain = grain;
+		m_next = 0;
+		m_pendingWorkers = m_threads.size();
+		m_jobID += 1;
+	}
+	m_wake.notify_all();
+	this->work();
+	std::unique_lock lock(m_mutex);
+	m_done.wait(lock, [&] { return m_pendingWorkers == 0; });
+	m_job = nullptr;
+}
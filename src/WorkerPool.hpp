@@ -0,0 +1,84 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A small fixed set of worker threads for splitting work on large listener
+// lists into chunks. Only meant to be used from the game thread, which
+// also works on the chunks while it waits for the workers
+class WorkerPool {
+protected:
+	using Job = std::function<void(size_t begin, size_t end)>;
+
+	std::vector<std::thread> m_threads;
+	std::mutex m_mutex;
+	std::condition_variable m_wake;
+	std::condition_variable m_done;
+	bool m_stopping = false;
+
+	// the job currently being worked on
+	Job m_job;
+	size_t m_count = 0;
+	size_t m_grain = 1;
+	std::atomic_size_t m_next = 0;
+	size_t m_pendingWorkers = 0;
+	size_t m_jobID = 0;
+
+	void run(size_t seen);
+	void work();
+	void stop();
+
+public:
+	static WorkerPool* get();
+
+	~WorkerPool();
+
+	/**
+	 * Set the number of threads used for parallel work, including the game
+	 * thread. 1 or less runs everything on the game thread
+	 */
+	void setThreadCount(size_t count);
+	size_t getThreadCount() const;
+
+	/**
+	 * Call fn on chunks of at most grain items covering [0, count) and
+	 * wait for all of them to finish. Chunks may run in any order and on
+	 * any thread
+	 */
+	void parallelFor(size_t count, size_t grain, Job fn);
+
+	/**
+	 * Sort one chunk per thread and merge the sorted chunks pairwise
+	 */
+	template <class T, class Compare>
+	void parallelSort(std::vector<T>& items, Compare compare) {
+		auto threads = this->getThreadCount();
+		if (threads <= 1 || items.size() < threads * 2) {
+			std::sort(items.begin(), items.end(), compare);
+			return;
+		}
+		auto size = items.size();
+		auto chunk = (size + threads - 1) / threads;
+		this->parallelFor(size, chunk, [&](size_t begin, size_t end) {
+			std::sort(items.begin() + begin, items.begin() + end, compare);
+		});
+		for (auto width = chunk; width < size; width *= 2) {
+			auto pairs = (size + width * 2 - 1) / (width * 2);
+			this->parallelFor(pairs, 1, [&](size_t begin, size_t end) {
+				for (size_t pair = begin; pair < end; pair++) {
+					auto first = pair * width * 2;
+					auto middle = std::min(first + width, size);
+					auto last = std::min(first + width * 2, size);
+					std::inplace_merge(
+						items.begin() + first, items.begin() + middle,
+						items.begin() + last, compare
+					);
+				}
+			});
+		}
+	}
+};
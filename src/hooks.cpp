@@ -1,7 +1,7 @@
+#include <Sapphire/modify/CCNode.hpp>
 #include <Sapphire/modify/CCLayer.hpp>
 #include <Sapphire/modify/CCMenu.hpp>
 #include <Sapphire/modify/CCTouchDispatcher.hpp>
-#include <Sapphire/modify/AchievementNotifier.hpp>
 #include <Sapphire/modify/CCTextInputNode.hpp>
 #include <Sapphire/utils/cocos.hpp>
 #include "../include/API.hpp"
@@ -10,48 +10,54 @@
 using namespace sapphire::prelude;
 using namespace mouse;
 
+struct $modify(CCNode) {
+    // Listeners parked while their node was out of the scene are added 
+    // back once it enters it again. Every touch delegate registered by the 
+    // node & its children entering the scene is added in one batch
+    void onEnter() {
+        Mouse::BatchScope batch;
+        CCNode::onEnter();
+        MouseEventListenerPool::get()->nodeEntered(this);
+    }
+};
+
+// The listeners added to touch delegates & menus always behave the same, so 
+// instead of a closure per node they only carry their behavior as a flag 
+// which the pool evaluates itself
+static void addDelegateProxy(CCNode* node, DelegateProxy proxy) {
+    node->addEventListener(
+        "mouse"_spr,
+        new EventListener<MouseEventFilter>(MouseEventFilter(node, proxy))
+    );
+    Mouse::updateListeners();
+}
+
 struct $modify(CCTouchDispatcher) {
     void addStandardDelegate(CCTouchDelegate* delegate, int prio) {
         CCTouchDispatcher::addStandardDelegate(delegate, prio);
         if (auto node = typeinfo_cast<CCNode*>(delegate)) {
             if (node->getEventListener("mouse"_spr)) return;
-            node->template addEventListener<MouseEventFilter>(
-                "mouse"_spr,
-                [=](MouseEvent*) {
-                    return MouseResult::Eat;
-                }
-            );
-            Mouse::updateListeners();
+            addDelegateProxy(node, DelegateProxy::Eat);
         }
     }
 
     void addTargetedDelegate(CCTouchDelegate* delegate, int prio, bool swallows) {
         CCTouchDispatcher::addTargetedDelegate(delegate, prio, swallows);
         if (auto node = typeinfo_cast<CCNode*>(delegate)) {
-            if (node->getEventListener("mouse"_spr)) return;
-            if (swallows) {
-                node->template addEventListener<MouseEventFilter>(
-                    "mouse"_spr,
-                    [=](MouseEvent*) {
-                        return MouseResult::Swallow;
-                    }
-                );
+            // Popups like FLAlertLayer swallow every touch with a higher 
+            // priority than menus, so nothing beneath them can be clicked
+            if (swallows && prio < kCCMenuHandlerPriority && !typeinfo_cast<CCMenu*>(node)) {
+                Mouse::setModal(node);
             }
-            else {
-                node->template addEventListener<MouseEventFilter>(
-                    "mouse"_spr,
-                    [=](MouseEvent*) {
-                        return MouseResult::Eat;
-                    }
-                );
-            }
-            Mouse::updateListeners();
+            if (node->getEventListener("mouse"_spr)) return;
+            addDelegateProxy(node, swallows ? DelegateProxy::Swallow : DelegateProxy::Eat);
         }
     }
 
     void removeDelegate(CCTouchDelegate* delegate) {
         if (auto node = typeinfo_cast<CCNode*>(delegate)) {
             node->removeEventListener("mouse"_spr);
+            Mouse::setModal(node, false);
             Mouse::updateListeners();
         }
         CCTouchDispatcher::removeDelegate(delegate);
@@ -70,30 +76,12 @@ struct $modify(CCTextInputNode) {
 
 struct $modify(CCMenu) {
     bool initWithArray(CCArray* items) {
+        Mouse::BatchScope batch;
         if (!CCMenu::initWithArray(items))
             return false;
 
-        this->template addEventListener<MouseEventFilter>(
-            "mouse"_spr,
-            [=](MouseEvent* ev) {
-                for (auto& child : CCArrayExt<CCNode>(m_pChildren)) {
-                    if (child->boundingBox().containsPoint(this->convertToNodeSpace(ev->getPosition()))) {
-                        return MouseResult::Swallow;
-                    }
-                }
-                return MouseResult::Leave;
-            },
-            true
-        );
-        Mouse::updateListeners();
+        addDelegateProxy(this, DelegateProxy::MenuChildren);
         
         return true;
     }
 };
-
-struct $modify(AchievementNotifier) {
-    void willSwitchToScene(CCScene* scene) {
-        AchievementNotifier::willSwitchToScene(scene);
-        Mouse::updateListeners();
-    }
-};
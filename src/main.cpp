@@ -7,6 +7,7 @@
 #include <json/stl_serialize.hpp>
 #include "Platform.hpp"
 #include "Pool.hpp"
+#include "State.hpp"
 
 json::Value json::Serialize<MouseButton>::to_json(MouseButton const& button) {
 	return static_cast<int>(button);
@@ -19,6 +20,7 @@ MouseButton json::Serialize<MouseButton>::from_json(json::Value const& json) {
 using List = std::unordered_set<MouseButton>;
 
 MouseAttributes* MouseAttributes::from(CCNode* node) {
+	StatCounters::add(StatCounters::get().attributeAllocations);
 	auto attrs = new MouseAttributes();
 	attrs->m_node = node;
 	attrs->autorelease();
@@ -76,8 +78,20 @@ CCNode* MouseEvent::getTarget() const {
 	return m_target;
 }
 
+// Counts the touches that are alive, so leaks show up in the stats
+struct MouseTouch : public CCTouch {
+	MouseTouch() {
+		StatCounters::add(StatCounters::get().touchAllocations);
+		StatCounters::add(StatCounters::get().touchesAlive);
+	}
+
+	~MouseTouch() override {
+		StatCounters::sub(StatCounters::get().touchesAlive);
+	}
+};
+
 CCTouch* MouseEvent::createTouch() const {
-	auto touch = new CCTouch();
+	auto touch = new MouseTouch();
 	// Never call autorelease on CCTouch. If you do it, at some point in the 
 	// future CCSequence::update will crash.
 	touch->m_point = CCDirector::get()->convertToUI(m_position);
@@ -130,12 +144,20 @@ bool MouseClickEvent::isDown() const {
 	return m_down;
 }
 
+MouseEventType MouseClickEvent::getType() const {
+	return MouseEventType::Click;
+}
+
 MouseMoveEvent::MouseMoveEvent(CCPoint const& pos)
   : MouseMoveEvent(nullptr, pos) {}
 
 MouseMoveEvent::MouseMoveEvent(CCNode* target, CCPoint const& pos)
   : MouseEvent(target, pos) {}
 
+MouseEventType MouseMoveEvent::getType() const {
+	return MouseEventType::Move;
+}
+
 void MouseMoveEvent::dispatchDefault(CCNode* target, CCTouch* touch) const {
 	if (!touch) return;
 	if (auto delegate = typeinfo_cast<CCTouchDelegate*>(target)) {
@@ -152,6 +174,12 @@ MouseScrollEvent::MouseScrollEvent(
 	CCNode* target, float deltaY, float deltaX, CCPoint const& pos
 ) : MouseEvent(target, pos), m_deltaY(deltaY), m_deltaX(deltaX) {}
 
+MouseScrollEvent::MouseScrollEvent(
+	CCNode* target, float deltaY, float deltaX, CCPoint const& pos,
+	size_t sampleCount, bool continuous
+) : MouseEvent(target, pos), m_deltaY(deltaY), m_deltaX(deltaX),
+	m_sampleCount(sampleCount), m_continuous(continuous) {}
+
 void MouseScrollEvent::dispatchDefault(CCNode* target, CCTouch*) const {
 	if (auto delegate = typeinfo_cast<CCMouseDelegate*>(target)) {
 		delegate->scrollWheel(m_deltaY, m_deltaY);
@@ -166,6 +194,18 @@ float MouseScrollEvent::getDeltaX() const {
 	return m_deltaX;
 }
 
+size_t MouseScrollEvent::getSampleCount() const {
+	return m_sampleCount;
+}
+
+bool MouseScrollEvent::isContinuous() const {
+	return m_continuous;
+}
+
+MouseEventType MouseScrollEvent::getType() const {
+	return MouseEventType::Scroll;
+}
+
 MouseHoverEvent::MouseHoverEvent(CCNode* target, bool enter, CCPoint const& pos)
   : MouseEvent(target, pos), m_enter(enter)
 {}
@@ -180,7 +220,71 @@ bool MouseHoverEvent::isLeave() const {
 	return !m_enter;
 }
 
+MouseEventType MouseHoverEvent::getType() const {
+	return MouseEventType::Hover;
+}
+
+MouseDoubleClickEvent::MouseDoubleClickEvent(
+	CCNode* target, MouseButton button, CCPoint const& pos
+) : MouseEvent(target, pos), m_button(button) {}
+
+void MouseDoubleClickEvent::dispatchDefault(CCNode*, CCTouch*) const {}
+
+MouseButton MouseDoubleClickEvent::getButton() const {
+	return m_button;
+}
+
+MouseEventType MouseDoubleClickEvent::getType() const {
+	return MouseEventType::DoubleClick;
+}
+
+MouseLongPressEvent::MouseLongPressEvent(
+	CCNode* target, MouseButton button, CCPoint const& pos
+) : MouseEvent(target, pos), m_button(button) {}
+
+void MouseLongPressEvent::dispatchDefault(CCNode*, CCTouch*) const {}
+
+MouseButton MouseLongPressEvent::getButton() const {
+	return m_button;
+}
+
+MouseEventType MouseLongPressEvent::getType() const {
+	return MouseEventType::LongPress;
+}
+
+MouseDragEvent::MouseDragEvent(
+	CCNode* target, MouseButton button,
+	CCPoint const& startPos, CCPoint const& pos
+) : MouseEvent(target, pos), m_button(button), m_startPosition(startPos) {}
+
+void MouseDragEvent::dispatchDefault(CCNode*, CCTouch*) const {}
+
+MouseButton MouseDragEvent::getButton() const {
+	return m_button;
+}
+
+CCPoint MouseDragEvent::getStartPosition() const {
+	return m_startPosition;
+}
+
+CCPoint MouseDragEvent::getDelta() const {
+	return m_position - m_startPosition;
+}
+
+MouseEventType MouseDragEvent::getType() const {
+	return MouseEventType::Drag;
+}
+
 ListenerResult MouseEventFilter::handle(MiniFunction<Callback> fn, MouseEvent* event) {
+	// Deferred callbacks are delivered after everything else already 
+	// happened when the event was dispatched
+	auto pool = MouseEventListenerPool::get();
+	if (pool->takeDelivery(this->getListener())) {
+		if (fn) {
+			pool->setDeferredResult(this->getListener(), fn(event));
+		}
+		return ListenerResult::Propagate;
+	}
 	if (m_target) {
 		// Make sure to get a Ref to the target so if it gets released during 
 		// the execution of this function for example due to ccTouchEnded then 
@@ -190,11 +294,7 @@ ListenerResult MouseEventFilter::handle(MiniFunction<Callback> fn, MouseEvent* e
 			return ListenerResult::Propagate;
 		}
 		// Events will only be dispatched to nodes in the scene that are visible
-		bool inside =
-			m_ignorePosition ||
-			target->boundingBox().containsPoint(
-				target->getParent()->convertToNodeSpace(event->getPosition())
-			);
+		bool inside = MouseEventListenerPool::get()->hitTest(*this, event->getPosition());
 		
 		bool capturing = !Mouse::get()->getCapturing() ||
 			Mouse::get()->getCapturing() == this->getListener();
@@ -223,10 +323,12 @@ ListenerResult MouseEventFilter::handle(MiniFunction<Callback> fn, MouseEvent* e
 			// Post hover event
 			if (capturing && !attrs->isHovered() && inside) {
 				attrs->setHovered(true);
+				StatCounters::add(StatCounters::get().hoverEnters);
 				MouseHoverEvent(target, true, event->getPosition()).post();
 			}
 			else if (capturing && attrs->isHovered() && !inside) {
 				attrs->setHovered(false);
+				StatCounters::add(StatCounters::get().hoverLeaves);
 				MouseHoverEvent(target, false, event->getPosition()).post();
 			}
 			// Add click to held list (may be something the callback needs 
@@ -240,7 +342,8 @@ ListenerResult MouseEventFilter::handle(MiniFunction<Callback> fn, MouseEvent* e
 					attrs->removeHeld(click->getButton());
 				}
 			}
-			auto s = fn(event);
+			// delegate proxies are invoked by the pool without a callback
+			auto s = fn ? fn(event) : this->getProxyResult(event);
 			if (s == MouseResult::Leave) {
 				// If the callback didn't want to capture the mouse, release 
 				// the hold attribute immediately
@@ -251,11 +354,11 @@ ListenerResult MouseEventFilter::handle(MiniFunction<Callback> fn, MouseEvent* e
 			else {
 				// Eat if clicked
 				if (click && click->isDown()) {
-					m_eaten = event->createTouch();
+					m_eaten = MouseEventListenerPool::get()->getSessionTouch(event);
 				}
 			}
 			if (m_eaten) {
-				event->updateTouch(m_eaten);
+				MouseEventListenerPool::get()->updateTouch(m_eaten, event);
 			}
 			event->dispatchDefault(target, m_eaten);
 			// Release eaten only after dispatching the touch event so the 
@@ -281,8 +384,10 @@ ListenerResult MouseEventFilter::handle(MiniFunction<Callback> fn, MouseEvent* e
 				}
 				// keep propagating so every remaining listener gets their 
 				// hover event posted
+				this->updateStateful(attrs->isHovered());
 				return ListenerResult::Propagate;
 			}
+			this->updateStateful(attrs->isHovered());
 			return ListenerResult::Propagate;
 		}
 		// If this target doesn't get the event, propagate onwards
@@ -291,17 +396,19 @@ ListenerResult MouseEventFilter::handle(MiniFunction<Callback> fn, MouseEvent* e
 			// Post hover leave event if necessary
 			if (attrs->isHovered() && !inside) {
 				attrs->setHovered(false);
+				StatCounters::add(StatCounters::get().hoverLeaves);
 				MouseHoverEvent(target, false, event->getPosition()).post();
 			}
 			attrs->clearHeld();
 			m_eaten = nullptr;
+			this->updateStateful(attrs->isHovered());
 			return ListenerResult::Propagate;
 		}
 	}
 	// Otherwise handle global listeners, which will only be fired if no node 
 	// is capturing the mouse
 	else if (!event->getTarget()) {
-		auto s = fn(event);
+		auto s = fn ? fn(event) : this->getProxyResult(event);
 		if (s == MouseResult::Swallow) {
 			event->swallow();
 			return ListenerResult::Propagate;
@@ -314,6 +421,61 @@ ListenerResult MouseEventFilter::handle(MiniFunction<Callback> fn, MouseEvent* e
 	}
 }
 
+bool MouseEventFilter::isUnder(CCPoint const& pos) const {
+	if (m_ignorePosition) {
+		return true;
+	}
+	// Menus are hit by their items, which may be anywhere around the menu
+	if (m_proxy == DelegateProxy::MenuChildren) {
+		auto bounds = MouseEventListenerPool::get()->getContainerBounds(m_target);
+		if (!bounds.containsPoint(pos)) {
+			return false;
+		}
+		auto local = m_target->convertToNodeSpace(pos);
+		for (auto& child : CCArrayExt<CCNode>(m_target->getChildren())) {
+			if (child->boundingBox().containsPoint(local)) {
+				return true;
+			}
+		}
+		return false;
+	}
+	auto parent = m_target->getParent();
+	if (!parent) {
+		return false;
+	}
+	if (m_hitShape.getType() == HitShapeType::Bounds) {
+		return m_target->boundingBox().containsPoint(parent->convertToNodeSpace(pos));
+	}
+	return m_hitShape.contains(m_target->convertToNodeSpace(pos), m_target->getContentSize());
+}
+
+void MouseEventFilter::occlude(CCPoint const& pos) {
+	if (!m_target) {
+		return;
+	}
+	Ref target { m_target };
+	auto attrs = MouseAttributes::from(target);
+	if (attrs->isHovered()) {
+		attrs->setHovered(false);
+		StatCounters::add(StatCounters::get().hoverLeaves);
+		MouseHoverEvent(target, false, pos).post();
+	}
+	attrs->clearHeld();
+	m_eaten = nullptr;
+	this->updateStateful(false);
+}
+
+void MouseEventFilter::updateStateful(bool hovered) {
+	// Hovered and eating listeners always need to see events so they can 
+	// post their leave events and update their touches, so let the pool 
+	// know it can't skip them
+	bool stateful = hovered || m_eaten;
+	if (stateful != m_stateful) {
+		m_stateful = stateful;
+		MouseEventListenerPool::get()->updateState(this->getListener());
+	}
+}
+
 CCNode* MouseEventFilter::getTarget() const {
 	return m_target;
 }
@@ -337,15 +499,84 @@ size_t MouseEventFilter::getFilterIndex() const {
 	return m_filterIndex;
 }
 
+void MouseEventFilter::setInterest(unsigned int types) {
+	m_interest = types;
+	// the pool keeps its own copy of the interest mask
+	MouseEventListenerPool::get()->invalidate();
+}
+
+unsigned int MouseEventFilter::getInterest() const {
+	return m_interest;
+}
+
+bool MouseEventFilter::isInterestedIn(MouseEventType type) const {
+	return m_interest & static_cast<unsigned int>(type);
+}
+
+void MouseEventFilter::setPriorityClass(PriorityClass priority) {
+	m_priorityClass = priority;
+	MouseEventListenerPool::get()->invalidate();
+}
+
+PriorityClass MouseEventFilter::getPriorityClass() const {
+	return m_priorityClass;
+}
+
+void MouseEventFilter::setHitShape(HitShape const& shape) {
+	m_hitShape = shape;
+	// cached hit test results & snapshots have the old shape
+	MouseEventListenerPool::get()->invalidate();
+}
+
+HitShape const& MouseEventFilter::getHitShape() const {
+	return m_hitShape;
+}
+
 MouseEventFilter::MouseEventFilter(CCNode* target, bool ignorePosition)
   : m_target(target),
   	m_ignorePosition(ignorePosition),
   	m_filterIndex(target ? target->getEventListenerCount() : 0)
 {}
 
+MouseEventFilter::MouseEventFilter(CCNode* target, DelegateProxy proxy)
+  : MouseEventFilter(target)
+{
+	m_proxy = proxy;
+}
+
 MouseEventFilter::~MouseEventFilter() {}
 
+DelegateProxy MouseEventFilter::getDelegateProxy() const {
+	return m_proxy;
+}
+
+MouseResult MouseEventFilter::getProxyResult(MouseEvent* event) const {
+	switch (m_proxy) {
+		case DelegateProxy::Eat: return MouseResult::Eat;
+		case DelegateProxy::Swallow: return MouseResult::Swallow;
+		case DelegateProxy::MenuChildren: {
+			// the items were already hit tested when checking the target
+			return MouseEventListenerPool::get()->hitTest(*this, event->getPosition()) ?
+				MouseResult::Swallow : MouseResult::Leave;
+		}
+		default: return MouseResult::Leave;
+	}
+}
+
+Mouse::BatchScope::BatchScope() {
+	MouseEventListenerPool::get()->beginBatch();
+}
+
+Mouse::BatchScope::~BatchScope() {
+	MouseEventListenerPool::get()->endBatch();
+}
+
 void Mouse::updateListeners() {
+	// the batch updates the listeners once it's done
+	if (MouseEventListenerPool::get()->isBatching()) {
+		MouseEventListenerPool::get()->sortAfterBatch();
+		return;
+	}
 	if (s_updating) return;
 	s_updating = true;
 	// update only once per frame at most
@@ -355,13 +586,105 @@ void Mouse::updateListeners() {
 	});
 }
 
+size_t Mouse::getListenerCount() {
+	return MouseEventListenerPool::get()->getListenerCount();
+}
+
+size_t Mouse::getListenerSlotCount() {
+	return MouseEventListenerPool::get()->getSlotCount();
+}
+
+void Mouse::setDeferredBudget(float seconds) {
+	MouseEventListenerPool::get()->setDeferredBudget(seconds);
+}
+
+float Mouse::getDeferredBudget() {
+	return MouseEventListenerPool::get()->getDeferredBudget();
+}
+
+DeferredStats Mouse::getDeferredStats() {
+	return MouseEventListenerPool::get()->getDeferredStats();
+}
+
+std::vector<CCNode*> Mouse::pick(CCPoint const& point, size_t maxResults) {
+	return MouseEventListenerPool::get()->pick({ point }, maxResults).front();
+}
+
+std::vector<std::vector<CCNode*>> Mouse::pick(std::vector<CCPoint> const& points, size_t maxResults) {
+	return MouseEventListenerPool::get()->pick(points, maxResults);
+}
+
+void Mouse::setWorkerThreads(size_t count) {
+	WorkerPool::get()->setThreadCount(count);
+}
+
+size_t Mouse::getWorkerThreads() {
+	return WorkerPool::get()->getThreadCount();
+}
+
+void Mouse::setTimelineEnabled(bool enabled) {
+	Timeline::get()->setEnabled(enabled);
+}
+
+bool Mouse::isTimelineEnabled() {
+	return Timeline::get()->isEnabled();
+}
+
+std::vector<MouseTimelineEntry> Mouse::queryTimeline(
+	MiniFunction<bool(MouseTimelineEntry const&)> filter, size_t maxResults
+) {
+	return Timeline::get()->query(filter, maxResults);
+}
+
+bool Mouse::dumpTimeline(std::filesystem::path const& path) {
+	return Timeline::get()->dump(path);
+}
+
+void Mouse::setModal(CCNode* node, bool modal) {
+	MouseEventListenerPool::get()->setModal(node, modal);
+}
+
+bool Mouse::isModal(CCNode* node) {
+	return MouseEventListenerPool::get()->isModal(node);
+}
+
+CCNode* Mouse::getModal() {
+	return MouseEventListenerPool::get()->getModal();
+}
+
+std::vector<OrphanedListener> Mouse::auditListeners() {
+	return MouseEventListenerPool::get()->getOrphans();
+}
+
+void Mouse::setOrphanPurgeFrames(unsigned int frames) {
+	MouseEventListenerPool::get()->setOrphanPurgeFrames(frames);
+}
+
+unsigned int Mouse::getOrphanPurgeFrames() {
+	return MouseEventListenerPool::get()->getOrphanPurgeFrames();
+}
+
+MouseStats Mouse::getStats() {
+	auto pool = MouseEventListenerPool::get();
+	auto stats = StatCounters::get().read();
+	stats.listenerCount = pool->getListenerCount();
+	stats.listenerSlotCount = pool->getSlotCount();
+	stats.deferred = pool->getDeferredStats();
+	return stats;
+}
+
+void Mouse::resetStats() {
+	StatCounters::get().reset();
+	MouseEventListenerPool::get()->resetDeferredStats();
+}
+
 Mouse* Mouse::get() {
 	static auto inst = new Mouse;
 	return inst;
 }
 
 bool Mouse::isHeld(MouseButton button) const {
-	return m_heldButtons.contains(button);
+	return PointerState::get().isHeld(button);
 }
 
 EventListener<MouseEventFilter>* Mouse::getCapturing() const {
@@ -388,8 +711,12 @@ struct MouseEventContainer : public CCEvent {
 };
 
 void postMouseEventThroughTouches(MouseEvent& event, ccTouchType action) {
-	auto set = CCSet::create();
-	set->addObject(event.createTouch());
+	// The set is created without autoreleasing it, as it's released right 
+	// after dispatching, and it holds the only reference to the touch
+	auto set = new CCSet();
+	auto touch = event.createTouch();
+	set->addObject(touch);
+	touch->release();
 	CCTouchDispatcher::get()->touches(set, new MouseEventContainer(event), action);
 	set->release();
 }
@@ -404,6 +731,9 @@ struct $modify(CCTouchDispatcherModify, CCTouchDispatcher) {
 			// Update event position in case some touches hook changed it
 			me->event.m_position = static_cast<CCTouch*>(set->anyObject())->getLocation();
 			me->event.post();
+			// gestures are recognized once per raw event, after the listeners
+			// have had a chance to capture the mouse
+			recognizeGestures(me->event);
 		}
 		else {
 			CCTouchDispatcher::touches(set, event, type);
@@ -1,6 +1,9 @@
 #include <Sapphire/modify/MenuLayer.hpp>
 #include "../include/API.hpp"
 #include "../include/ContextMenu.hpp"
+#include "Pool.hpp"
+#include <chrono>
+#include <cmath>
 
 using namespace sapphire::prelude;
 using namespace mouse;
@@ -51,7 +54,201 @@ public:
     }
 };
 
+// Restart the workers and give them a job right away, before they've had 
+// a chance to start waiting. Hangs if a worker misses its first job
+static bool checkWorkerStartup(size_t threads) {
+    constexpr size_t RESTART_COUNT = 100;
+    constexpr size_t ITEM_COUNT = 4096;
+
+    for (size_t i = 0; i < RESTART_COUNT; i++) {
+        Mouse::setWorkerThreads(1);
+        Mouse::setWorkerThreads(threads);
+        std::atomic_size_t done = 0;
+        WorkerPool::get()->parallelFor(ITEM_COUNT, 64, [&](size_t begin, size_t end) {
+            done += end - begin;
+        });
+        if (done != ITEM_COUNT) {
+            log::error("Worker startup check failed: {} of {} items done with {} threads", done.load(), ITEM_COUNT, threads);
+            return false;
+        }
+    }
+    return true;
+}
+
+// Time sorting & dispatching to a large number of listeners with every 
+// worker thread count from 1 to 8
+static void runParallelBenchmark() {
+    using Clock = std::chrono::steady_clock;
+    constexpr size_t GROUP_COUNT = 100;
+    constexpr size_t GROUP_SIZE = 200;
+    constexpr size_t MOVE_COUNT = 100;
+
+    for (size_t threads = 2; threads <= 8; threads++) {
+        if (!checkWorkerStartup(threads)) {
+            Mouse::setWorkerThreads(1);
+            return;
+        }
+    }
+
+    auto winSize = CCDirector::get()->getWinSize();
+    auto root = CCNode::create();
+    for (size_t g = 0; g < GROUP_COUNT; g++) {
+        auto group = CCNode::create();
+        group->setPosition(
+            (g % 10) * winSize.width / 10,
+            (g / 10) * winSize.height / 10
+        );
+        root->addChild(group);
+        for (size_t i = 0; i < GROUP_SIZE; i++) {
+            auto node = CCNode::create();
+            node->setContentSize({ 4.f, 4.f });
+            node->setPosition((i % 20) * 2.f, (i / 20) * 2.f);
+            node->template addEventListener<MouseEventFilter>([](MouseEvent*) {
+                return MouseResult::Leave;
+            });
+            group->addChild(node);
+        }
+    }
+    CCScene::get()->addChild(root);
+
+    auto pool = MouseEventListenerPool::get();
+    for (size_t threads = 1; threads <= 8; threads++) {
+        Mouse::setWorkerThreads(threads);
+
+        auto start = Clock::now();
+        pool->sortListeners();
+        auto sortTime = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+
+        start = Clock::now();
+        for (size_t i = 0; i < MOVE_COUNT; i++) {
+            MouseMoveEvent(ccp(
+                winSize.width * i / MOVE_COUNT,
+                winSize.height * (MOVE_COUNT - i) / MOVE_COUNT
+            )).post();
+        }
+        auto moveTime = std::chrono::duration<float, std::milli>(Clock::now() - start).count();
+
+        log::info(
+            "{} threads, {} listeners: sort {:.2f}ms, {} moves {:.2f}ms",
+            threads, Mouse::getListenerCount(), sortTime, MOVE_COUNT, moveTime
+        );
+    }
+    Mouse::setWorkerThreads(1);
+    root->removeFromParent();
+}
+
+// Most touches alive seen by the soak test's listeners
+static uint64_t s_soakPeak = 0;
+
+// Post millions of synthetic events through the same path as real input 
+// and check that the touches created for them don't pile up
+static void runSoakTest() {
+    using Clock = std::chrono::steady_clock;
+    constexpr size_t NODE_COUNT = 64;
+    constexpr size_t EVENT_COUNT = 2'000'000;
+    constexpr size_t BATCH_SIZE = 10'000;
+
+    auto& counters = StatCounters::get();
+    auto before = counters.touchesAlive.load();
+    s_soakPeak = before;
+    auto winSize = CCDirector::get()->getWinSize();
+    auto root = CCNode::create();
+    for (size_t i = 0; i < NODE_COUNT; i++) {
+        auto node = CCNode::create();
+        node->setContentSize({ 40.f, 40.f });
+        node->setPosition(
+            (i % 8) * winSize.width / 8,
+            (i / 8) * winSize.height / 8
+        );
+        // eating nodes hold on to the press' touch until it's released
+        bool eats = i % 2;
+        node->template addEventListener<MouseEventFilter>([=](MouseEvent*) {
+            // sampled mid-dispatch, while the press' touches are alive
+            s_soakPeak = std::max(s_soakPeak, StatCounters::get().touchesAlive.load());
+            return eats ? MouseResult::Eat : MouseResult::Swallow;
+        });
+        root->addChild(node);
+    }
+    CCScene::get()->addChild(root);
+    MouseEventListenerPool::get()->sortListeners();
+
+    auto start = Clock::now();
+    for (size_t i = 0; i < EVENT_COUNT; i += BATCH_SIZE) {
+        // autoreleased objects are freed after every batch instead of at 
+        // the end of the frame
+        CCPoolManager::sharedPoolManager()->push();
+        for (size_t j = 0; j < BATCH_SIZE; j += 4) {
+            auto n = static_cast<float>(i + j);
+            auto pos = ccp(std::fmod(n * 37.f, winSize.width), std::fmod(n * 53.f, winSize.height));
+
+            auto move = MouseMoveEvent(Mouse::get()->getCapturingNode(), pos);
+            postMouseEventThroughTouches(move, CCTOUCHOTHER);
+            auto down = MouseClickEvent(Mouse::get()->getCapturingNode(), MouseButton::Left, true, pos);
+            postMouseEventThroughTouches(down, CCTOUCHBEGAN);
+            auto drag = MouseMoveEvent(Mouse::get()->getCapturingNode(), pos + ccp(3.f, 3.f));
+            postMouseEventThroughTouches(drag, CCTOUCHMOVED);
+            auto up = MouseClickEvent(Mouse::get()->getCapturingNode(), MouseButton::Left, false, pos + ccp(3.f, 3.f));
+            postMouseEventThroughTouches(up, CCTOUCHENDED);
+        }
+        CCPoolManager::sharedPoolManager()->pop();
+    }
+    auto time = std::chrono::duration<float>(Clock::now() - start).count();
+    auto after = counters.touchesAlive.load();
+    auto peak = s_soakPeak;
+    root->removeFromParent();
+
+    // Every touch has been released after the last click. In between, the 
+    // eating nodes share one touch per press, and the only other one is 
+    // the touch in the set the event is posted through
+    if (after > before || peak > before + 2) {
+        log::error(
+            "Soak test failed: {} touches alive before, {} after, {} at peak",
+            before, after, peak
+        );
+    }
+    else {
+        log::info("Soak test passed: {} events in {:.2f}s, {} touches alive at peak", EVENT_COUNT, time, peak);
+    }
+}
+
+// Log how many listeners are delegate proxies, which don't own a callback, 
+// and how many carry one
+static void reportListenerFootprint() {
+    size_t proxies = 0;
+    size_t callbacks = 0;
+    for (auto listener : MouseEventListenerPool::get()->getSortedListeners()) {
+        if (listener->getFilter().getDelegateProxy() != DelegateProxy::None) {
+            proxies += 1;
+        }
+        else {
+            callbacks += 1;
+        }
+    }
+    log::info(
+        "{} delegate proxies & {} callback listeners, {} bytes per listener "
+        "object not counting what its callback allocates",
+        proxies, callbacks, sizeof(MouseListener)
+    );
+}
+
 $execute {
+    new EventListener<ContextMenuFilter>(+[](CCNode*) {
+        reportListenerFootprint();
+        return ListenerResult::Propagate;
+    }, ContextMenuFilter("footprint"_spr));
+
+    new EventListener<ContextMenuFilter>(+[](CCNode*) {
+        runParallelBenchmark();
+        return ListenerResult::Propagate;
+    }, ContextMenuFilter("benchmark"_spr));
+
+    new EventListener<ContextMenuFilter>(+[](CCNode*) {
+        // run outside of the click's dispatch so the test nodes' listeners 
+        // are added right away
+        Loader::get()->queueInGDThread(&runSoakTest);
+        return ListenerResult::Propagate;
+    }, ContextMenuFilter("soak-test"_spr));
+
     new EventListener<ContextMenuFilter>(+[](CCNode*) {
         FLAlertLayer::create("Hiii", "Yay it works", "OK")->show();
         return ListenerResult::Propagate;
@@ -136,6 +333,7 @@ struct $modify(MenuLayer) {
                         { "precision", 1.0 },
                         { "drag", "node-y"_spr },
                         { "ratio", .5 },
+                        { "coalesce", true },
                     },
                     json::Object {
                         { "text", "Sub menu" },
@@ -146,6 +344,18 @@ struct $modify(MenuLayer) {
                             }
                         } },
                     },
+                    json::Object {
+                        { "text", "Benchmark" },
+                        { "click", "benchmark"_spr },
+                    },
+                    json::Object {
+                        { "text", "Soak Test" },
+                        { "click", "soak-test"_spr },
+                    },
+                    json::Object {
+                        { "text", "Listener Footprint" },
+                        { "click", "footprint"_spr },
+                    },
                     json::Object {
                         { "text", "Quit Game" },
                         { "click", "quit-game"_spr },